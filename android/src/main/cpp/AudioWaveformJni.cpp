@@ -0,0 +1,230 @@
+//
+//  AudioWaveformJni.cpp
+//  AudioWaveform
+//
+//  JNI bindings for com.audiowaveform.WaveformReducer, PeakPyramid, PeakCache
+//  and WaveformJsi.
+//
+
+#include <jni.h>
+
+#include <cstdint>
+#include <string>
+
+#include "LevelHistory.h"
+#include "PeakCache.h"
+#include "PeakPyramid.h"
+#include "WaveformBufferStore.h"
+#include "WaveformJsi.h"
+#include "WaveformReducer.h"
+
+#include <jsi/jsi.h>
+
+using audiowaveform::LevelHistory;
+using audiowaveform::PeakCache;
+using audiowaveform::PeakLevel;
+using audiowaveform::PeakPyramid;
+using audiowaveform::SampleFormat;
+using audiowaveform::WaveformBufferStore;
+using audiowaveform::WaveformReducer;
+
+namespace {
+
+WaveformReducer *fromHandle(jlong handle) { return reinterpret_cast<WaveformReducer *>(handle); }
+
+PeakPyramid *pyramidFromHandle(jlong handle) { return reinterpret_cast<PeakPyramid *>(handle); }
+
+size_t reduceInto(JNIEnv *env, WaveformReducer *reducer, const void *pcm, jint size, jint encodingBit,
+                  jfloatArray rmsOut, jfloatArray peakOut, jint capacity) {
+  auto *rms = static_cast<float *>(env->GetPrimitiveArrayCritical(rmsOut, nullptr));
+  if (rms == nullptr) return 0;
+  float *peak = nullptr;
+  if (peakOut != nullptr) {
+    peak = static_cast<float *>(env->GetPrimitiveArrayCritical(peakOut, nullptr));
+  }
+  const size_t written = reducer->process(pcm, static_cast<size_t>(size), static_cast<SampleFormat>(encodingBit),
+                                          rms, peak, static_cast<size_t>(capacity));
+  if (peak != nullptr) env->ReleasePrimitiveArrayCritical(peakOut, peak, 0);
+  env->ReleasePrimitiveArrayCritical(rmsOut, rms, 0);
+  return written;
+}
+
+std::string toString(JNIEnv *env, jstring value) {
+  const char *chars = env->GetStringUTFChars(value, nullptr);
+  std::string result = chars != nullptr ? chars : "";
+  if (chars != nullptr) env->ReleaseStringUTFChars(value, chars);
+  return result;
+}
+
+jfloatArray toFloatArray(JNIEnv *env, const std::vector<float> &values) {
+  jfloatArray array = env->NewFloatArray(static_cast<jsize>(values.size()));
+  if (array != nullptr) env->SetFloatArrayRegion(array, 0, static_cast<jsize>(values.size()), values.data());
+  return array;
+}
+
+std::vector<float> toVector(JNIEnv *env, jfloatArray array) {
+  std::vector<float> values(static_cast<size_t>(env->GetArrayLength(array)));
+  env->GetFloatArrayRegion(array, 0, static_cast<jsize>(values.size()), values.data());
+  return values;
+}
+
+} // namespace
+
+extern "C" {
+
+JNIEXPORT jlong JNICALL
+Java_com_audiowaveform_WaveformReducer_nativeCreate(JNIEnv *, jobject, jint channels, jlong framesPerBucket,
+                                                    jint mode) {
+  return reinterpret_cast<jlong>(
+      new WaveformReducer(channels, framesPerBucket, static_cast<audiowaveform::ChannelMode>(mode)));
+}
+
+JNIEXPORT void JNICALL
+Java_com_audiowaveform_WaveformReducer_nativeDestroy(JNIEnv *, jobject, jlong handle) {
+  delete fromHandle(handle);
+}
+
+JNIEXPORT jint JNICALL
+Java_com_audiowaveform_WaveformReducer_nativeProcess(JNIEnv *env, jobject, jlong handle, jbyteArray data,
+                                                     jint size, jint encodingBit, jfloatArray rmsOut,
+                                                     jfloatArray peakOut, jint capacity) {
+  // Critical sections keep the JVM from copying the arrays back and forth.
+  void *pcm = env->GetPrimitiveArrayCritical(data, nullptr);
+  size_t written = 0;
+  if (pcm != nullptr) {
+    written = reduceInto(env, fromHandle(handle), pcm, size, encodingBit, rmsOut, peakOut, capacity);
+    env->ReleasePrimitiveArrayCritical(data, pcm, JNI_ABORT);
+  }
+  return static_cast<jint>(written);
+}
+
+JNIEXPORT jint JNICALL
+Java_com_audiowaveform_WaveformReducer_nativeProcessDirect(JNIEnv *env, jobject, jlong handle, jobject buffer,
+                                                           jint offset, jint size, jint encodingBit,
+                                                           jfloatArray rmsOut, jfloatArray peakOut,
+                                                           jint capacity) {
+  // MediaCodec output buffers are direct, so the decoded PCM is read in place.
+  auto *base = static_cast<uint8_t *>(env->GetDirectBufferAddress(buffer));
+  if (base == nullptr) return 0;
+  return static_cast<jint>(
+      reduceInto(env, fromHandle(handle), base + offset, size, encodingBit, rmsOut, peakOut, capacity));
+}
+
+JNIEXPORT void JNICALL
+Java_com_audiowaveform_WaveformReducer_nativeReset(JNIEnv *, jobject, jlong handle) {
+  fromHandle(handle)->reset();
+}
+
+JNIEXPORT jint JNICALL
+Java_com_audiowaveform_WaveformReducer_nativeMaxBucketsFor(JNIEnv *, jobject, jlong handle, jint size,
+                                                           jint encodingBit) {
+  return static_cast<jint>(
+      fromHandle(handle)->maxBucketsFor(static_cast<size_t>(size), static_cast<SampleFormat>(encodingBit)));
+}
+
+JNIEXPORT jfloat JNICALL
+Java_com_audiowaveform_WaveformReducer_nativeNormalizationMax(JNIEnv *env, jclass, jfloatArray values, jint count,
+                                                              jfloat threshold) {
+  auto *data = static_cast<float *>(env->GetPrimitiveArrayCritical(values, nullptr));
+  if (data == nullptr) return 1.0f;
+  const float maxValue = audiowaveform::normalizationMax(data, static_cast<size_t>(count), threshold);
+  env->ReleasePrimitiveArrayCritical(values, data, JNI_ABORT);
+  return maxValue;
+}
+
+JNIEXPORT void JNICALL
+Java_com_audiowaveform_WaveformReducer_nativeNormalize(JNIEnv *env, jclass, jfloatArray values, jint count,
+                                                       jfloat maxValue, jfloat scale, jfloat threshold) {
+  auto *data = static_cast<float *>(env->GetPrimitiveArrayCritical(values, nullptr));
+  if (data == nullptr) return;
+  audiowaveform::normalize(data, static_cast<size_t>(count), maxValue, scale, threshold);
+  env->ReleasePrimitiveArrayCritical(values, data, 0);
+}
+
+JNIEXPORT jobjectArray JNICALL
+Java_com_audiowaveform_PeakCache_nativeLoad(JNIEnv *env, jobject, jstring directory, jstring path,
+                                            jint bucketCount) {
+  PeakLevel level;
+  if (!PeakCache(toString(env, directory)).load(toString(env, path), static_cast<size_t>(bucketCount), level)) {
+    return nullptr;
+  }
+  jobjectArray result = env->NewObjectArray(2, env->FindClass("[F"), nullptr);
+  env->SetObjectArrayElement(result, 0, toFloatArray(env, level.rms));
+  env->SetObjectArrayElement(result, 1, toFloatArray(env, level.peak));
+  return result;
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_audiowaveform_PeakCache_nativeStore(JNIEnv *env, jobject, jstring directory, jstring path,
+                                             jfloatArray rms, jfloatArray peak) {
+  PeakLevel level;
+  level.rms = toVector(env, rms);
+  level.peak = toVector(env, peak);
+  return PeakCache(toString(env, directory)).store(toString(env, path), level) ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_audiowaveform_PeakPyramid_nativeCreate(JNIEnv *, jobject, jint channels, jlong totalFrames) {
+  return reinterpret_cast<jlong>(new PeakPyramid(channels, totalFrames));
+}
+
+JNIEXPORT void JNICALL
+Java_com_audiowaveform_PeakPyramid_nativeDestroy(JNIEnv *, jobject, jlong handle) {
+  delete pyramidFromHandle(handle);
+}
+
+JNIEXPORT void JNICALL
+Java_com_audiowaveform_PeakPyramid_nativeProcess(JNIEnv *env, jobject, jlong handle, jbyteArray data, jint size,
+                                                 jint encodingBit) {
+  void *pcm = env->GetPrimitiveArrayCritical(data, nullptr);
+  if (pcm == nullptr) return;
+  pyramidFromHandle(handle)->process(pcm, static_cast<size_t>(size), static_cast<SampleFormat>(encodingBit));
+  env->ReleasePrimitiveArrayCritical(data, pcm, JNI_ABORT);
+}
+
+JNIEXPORT void JNICALL
+Java_com_audiowaveform_PeakPyramid_nativeProcessDirect(JNIEnv *env, jobject, jlong handle, jobject buffer,
+                                                       jint offset, jint size, jint encodingBit) {
+  auto *base = static_cast<uint8_t *>(env->GetDirectBufferAddress(buffer));
+  if (base == nullptr) return;
+  pyramidFromHandle(handle)->process(base + offset, static_cast<size_t>(size),
+                                     static_cast<SampleFormat>(encodingBit));
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_audiowaveform_PeakPyramid_nativeStoreInCache(JNIEnv *env, jobject, jlong handle, jstring directory,
+                                                      jstring path, jfloatArray rms, jfloatArray peaks) {
+  PeakPyramid *pyramid = pyramidFromHandle(handle);
+  pyramid->finish();
+  // The directly reduced level goes into the same write as the pyramid
+  std::vector<PeakLevel> levels;
+  if (rms != nullptr && peaks != nullptr) levels.push_back(PeakLevel{toVector(env, rms), toVector(env, peaks)});
+  levels.insert(levels.end(), pyramid->levels().begin(), pyramid->levels().end());
+  return PeakCache(toString(env, directory)).store(toString(env, path), levels) ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_audiowaveform_WaveformJsi_nativeInstall(JNIEnv *, jobject, jlong runtime) {
+  audiowaveform::installJsiBindings(*reinterpret_cast<facebook::jsi::Runtime *>(runtime));
+  return JNI_TRUE;
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_audiowaveform_WaveformJsi_nativePutBuffer(JNIEnv *env, jobject, jfloatArray values, jint offset,
+                                                   jint count, jboolean isResult) {
+  std::vector<float> buffer(static_cast<size_t>(count));
+  env->GetFloatArrayRegion(values, offset, count, buffer.data());
+  return static_cast<jlong>(WaveformBufferStore::shared().put(std::move(buffer), isResult == JNI_TRUE));
+}
+
+JNIEXPORT void JNICALL
+Java_com_audiowaveform_LevelHistory_nativePush(JNIEnv *, jobject, jfloat level) {
+  LevelHistory::recording().push(level);
+}
+
+JNIEXPORT void JNICALL
+Java_com_audiowaveform_LevelHistory_nativeClear(JNIEnv *, jobject) {
+  LevelHistory::recording().clear();
+}
+
+} // extern "C"
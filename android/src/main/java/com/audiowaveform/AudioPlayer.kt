@@ -4,9 +4,7 @@ import android.content.Context
 import android.media.AudioAttributes
 import android.media.AudioFocusRequest
 import android.media.AudioManager
-import android.net.Uri
 import android.os.Build
-import android.os.CountDownTimer
 import android.os.Handler
 import com.facebook.react.bridge.Arguments
 import com.facebook.react.bridge.Promise
@@ -15,24 +13,30 @@ import com.facebook.react.bridge.WritableMap
 import com.facebook.react.common.JavascriptException
 import com.facebook.react.modules.core.DeviceEventManagerModule
 import androidx.media3.exoplayer.ExoPlayer
-import androidx.media3.common.MediaItem
 import androidx.media3.common.Player
 
 class AudioPlayer(
     context: ReactApplicationContext,
     playerKey: String,
+    private val ticker: PlaybackTicker,
+    private val pool: PlayerPool,
 ) {
     private val appContext = context
-    private lateinit var player: ExoPlayer
+    // Null while released, the pooled ExoPlayer may then belong to another AudioPlayer
+    private var player: ExoPlayer? = null
+    private var playerPath: String? = null
     private var audioManager: AudioManager = appContext.getSystemService(Context.AUDIO_SERVICE) as AudioManager
     private var audioFocusRequest: AudioFocusRequest? = null
     private var playerListener: Player.Listener? = null
     private var isPlayerPrepared: Boolean = false
     private var finishMode = FinishMode.Stop
-    private val key = playerKey
+    val key = playerKey
     private var updateFrequency = UpdateFrequency.Low
-    private lateinit var audioPlaybackListener: CountDownTimer
-    private var isComponentMounted = true // Flag to track mounting status
+    private var hasStartedPlaying = false
+    // When the current prepare started, until it is first heard, for PerfStats
+    private var prepareStartNanos = 0L
+    var isComponentMounted = true // Flag to track mounting status
+        private set
     private var isAudioFocusGranted=false
 
     init {
@@ -53,43 +57,41 @@ class AudioPlayer(
     }
 
     private fun handleAudioFocusChange(focusChange: Int) {
-        when (focusChange) {
-            AudioManager.AUDIOFOCUS_GAIN -> {
-                player.applicationLooper.let { looper -> Handler(looper).post {
+        val looper = player?.applicationLooper ?: return
+        Handler(looper).post {
+            // The player may have been handed back to the pool since the change was posted
+            val player = player ?: return@post
+            when (focusChange) {
+                AudioManager.AUDIOFOCUS_GAIN -> {
                     // Audio focus granted; resume playback if necessary
                     if (!player.isPlaying) {
                         player.play()
                     }
                     player.volume = 1.0f // Restore full volume
-                }}
-            }
-            AudioManager.AUDIOFOCUS_LOSS -> {
-                player.applicationLooper.let { looper -> Handler(looper).post {
+                }
+                AudioManager.AUDIOFOCUS_LOSS -> {
                     // Permanent loss of audio focus; pause playback
                     if (player.isPlaying) {
                         val args: WritableMap = Arguments.createMap()
                         stopListening()
                         player.pause()
+                        emitCurrentDuration()
                         abandonAudioFocus()
                         args.putInt(Constants.finishType, 1)
                         args.putString(Constants.playerKey, key)
                         appContext.getJSModule(DeviceEventManagerModule.RCTDeviceEventEmitter::class.java)?.emit("onDidFinishPlayingAudio", args)
                     }
-                }}
-            }
-            AudioManager.AUDIOFOCUS_LOSS_TRANSIENT -> {
-                player.applicationLooper.let { looper -> Handler(looper).post {
+                }
+                AudioManager.AUDIOFOCUS_LOSS_TRANSIENT -> {
                     // Temporary loss of audio focus; pause playback
                     if (player.isPlaying) {
                         player.pause()
                     }
-                }}
-            }
-            AudioManager.AUDIOFOCUS_LOSS_TRANSIENT_CAN_DUCK -> {
-                player.applicationLooper.let { looper -> Handler(looper).post {
+                }
+                AudioManager.AUDIOFOCUS_LOSS_TRANSIENT_CAN_DUCK -> {
                     // Temporarily loss of audio focus; but can continue playing at a lower volume.
                     player.volume = 0.2f
-                }}
+                }
             }
         }
     }
@@ -132,26 +134,39 @@ class AudioPlayer(
         promise: Promise
     ) {
         if (path != null) {
+            // Preparing again without a stop keeps the previous player out of the pool
+            releasePlayer()
             isPlayerPrepared = false
             isComponentMounted = true
             updateFrequency = frequency
-            val uri = Uri.parse(path)
-            val mediaItem = MediaItem.fromUri(uri)
-            player = ExoPlayer.Builder(appContext).build()
-            player.addMediaItem(mediaItem)
+            prepareStartNanos = System.nanoTime()
+            // Warm if the path was prefetched or played before, then it may already be ready
+            val player = pool.acquire(path)
+            this.player = player
+            playerPath = path
 
-            player.prepare()
+            val onReady = {
+                player.volume = (volume ?: 1).toFloat()
+                player.seekTo(progress)
+                isPlayerPrepared = true
+                val duration = player.duration
+                promise.resolve(duration.toString())
+            }
             playerListener = object : Player.Listener {
 
+                override fun onIsPlayingChanged(isPlaying: Boolean) {
+                    if (isPlaying && prepareStartNanos != 0L) {
+                        val latency = PerfStats.elapsedMs(prepareStartNanos)
+                        PerfStats.record(key) { prepareToFirstAudioMs = latency }
+                        prepareStartNanos = 0L
+                    }
+                }
+
                 @Deprecated("Deprecated in Java")
                 override fun onPlayerStateChanged(isReady: Boolean, state: Int) {
                     if (!isPlayerPrepared) {
                         if (state == Player.STATE_READY) {
-                            player.volume = (volume ?: 1).toFloat()
-                            player.seekTo(progress)
-                            isPlayerPrepared = true
-                            val duration = player.duration
-                            promise.resolve(duration.toString())
+                            onReady()
                         }
                     }
                     if (state == Player.STATE_ENDED) {
@@ -166,12 +181,12 @@ class AudioPlayer(
                                 player.seekTo(0)
                                 player.playWhenReady = false
                                 stopListening()
+                                emitCurrentDuration()
                                 args.putInt(Constants.finishType, 1)
                             }
                             else -> {
-                                player.stop()
-                                player.release()
                                 stopListening()
+                                releasePlayer()
                                 args.putInt(Constants.finishType, 2)
                             }
                         }
@@ -183,14 +198,18 @@ class AudioPlayer(
                 }
             }
             player.addListener(playerListener!!)
+            if (player.playbackState == Player.STATE_READY) onReady()
         } else {
             promise.reject("preparePlayer Error", "path to audio file or unique key can't be null")
         }
     }
 
     fun seekToPosition(progress: Long?, promise: Promise) {
-        if (progress != null) {
+        val player = player
+        if (progress != null && player != null) {
             player.seekTo(progress)
+            // Extrapolating listeners would run from the old position until the next tick
+            emitCurrentDuration()
             promise.resolve(true)
         } else {
             promise.resolve(false)
@@ -198,6 +217,10 @@ class AudioPlayer(
     }
 
     fun getDuration(durationType: DurationType, promise: Promise) {
+        val player = player ?: run {
+            promise.reject("getDuration Error", "Player is not prepared")
+            return
+        }
         if (durationType == DurationType.Current) {
             val duration = player.currentPosition
             promise.resolve(duration.toString())
@@ -219,6 +242,10 @@ class AudioPlayer(
     }
 
     fun start(finishMode: Int?, speed: Float?, promise: Promise) {
+        val player = player ?: run {
+            promise.reject("Can not start the player", "Player is not prepared")
+            return
+        }
         try {
             if (finishMode != null && finishMode == 0) {
                 this.finishMode = FinishMode.Loop
@@ -246,16 +273,27 @@ class AudioPlayer(
     fun stop() {
         stopListening()
         emitCurrentDuration()
-        if (playerListener != null) {
-            player.removeListener(playerListener!!)
-        }
-        isPlayerPrepared = false
-        player.stop()
-        player.release()
+        releasePlayer()
         abandonAudioFocus()
     }
 
+    /** Hands the player back to the pool, still prepared for its path. */
+    private fun releasePlayer() {
+        val path = playerPath ?: return
+        val player = player ?: return
+        playerPath = null
+        this.player = null
+        playerListener?.let { player.removeListener(it) }
+        playerListener = null
+        isPlayerPrepared = false
+        pool.recycle(path, player)
+    }
+
     fun pause(promise: Promise?) {
+        val player = player ?: run {
+            promise?.resolve(false)
+            return
+        }
         try {
             stopListening()
             player.pause()
@@ -270,7 +308,8 @@ class AudioPlayer(
 
     fun setVolume(volume: Float?, promise: Promise) {
         try {
-            if (volume != null) {
+            val player = player
+            if (volume != null && player != null) {
                 player.volume = volume
                 promise.resolve(true)
             } else {
@@ -282,40 +321,41 @@ class AudioPlayer(
     }
 
     fun setPlaybackSpeed(speed: Float?): Boolean {
-        return validateAndSetPlaybackSpeed(player, speed)
+        val player = player ?: return false
+        val status = validateAndSetPlaybackSpeed(player, speed)
+        emitCurrentDuration()
+        return status
     }
 
 
     fun emitCurrentDuration() {
-        val currentPosition = player.currentPosition.toString()
-        val args: WritableMap = Arguments.createMap()
-        args.putString(Constants.currentDuration, currentPosition)
-        args.putString(Constants.playerKey, key)
-        if (isComponentMounted) {
-            appContext.getJSModule(DeviceEventManagerModule.RCTDeviceEventEmitter::class.java)?.emit("onCurrentDuration", args)
-        }
+        ticker.emit(listOf(this))
+    }
+
+    /** The playback position in milliseconds, or null while no player is prepared */
+    fun currentPosition(): Long? {
+        return player?.currentPosition
     }
 
+    fun isPlaying(): Boolean = player?.isPlaying == true
+
+    fun playbackSpeed(): Float = player?.playbackParameters?.speed ?: 1f
+
     private fun startListening(promise: Promise) {
         try {
-            audioPlaybackListener = object : CountDownTimer(player.duration, UpdateFrequency.Low.value) {
-                override fun onTick(millisUntilFinished: Long) {
-                    emitCurrentDuration()
-                }
-                override fun onFinish() {}
-            }.start()
+            val looper = player?.applicationLooper ?: return
+            hasStartedPlaying = true
+            ticker.register(this, looper, updateFrequency)
         } catch(err: JavascriptException) {
             promise.reject("startListening Error", err)
         }
     }
 
     private fun stopListening() {
-        if (::audioPlaybackListener.isInitialized) {
-            audioPlaybackListener.cancel()
-        }
+        ticker.unregister(key)
     }
 
     fun isHoldingAudioTrack(): Boolean {
-        return ::audioPlaybackListener.isInitialized
+        return hasStartedPlaying
     }
 }
\ No newline at end of file
@@ -3,7 +3,7 @@ package com.audiowaveform
 import android.media.MediaRecorder
 import android.os.Build
 import android.os.Handler
-import android.os.Looper
+import android.os.HandlerThread
 import android.util.Log
 import androidx.annotation.RequiresApi
 import com.facebook.react.bridge.*
@@ -14,20 +14,35 @@ import java.io.IOException
 import java.text.SimpleDateFormat
 import java.util.Date
 import java.util.Locale
+import java.util.concurrent.Executors
 
 @ReactModule(name = AudioWaveformModule.NAME)
 class AudioWaveformModule(context: ReactApplicationContext) : ReactContextBaseJavaModule(context) {
-    private var extractors = mutableMapOf<String, WaveformExtractor?>()
+    private val extractionScheduler = ExtractionScheduler()
     private var audioPlayers = mutableMapOf<String, AudioPlayer?>()
+    private val playbackTicker = PlaybackTicker(context)
+    private val playerPool = PlayerPool(context)
     private var audioRecorder: AudioRecorder = AudioRecorder()
-    private var recorder: MediaRecorder? = null
+    // Read by the metering thread
+    @Volatile private var recorder: MediaRecorder? = null
+    // Set instead of recorder while recording with the AudioRecord engine
+    private var pcmRecorder: PcmRecorder? = null
     private var encoder: Int = 0
     private var path: String? = null
     private var outputFormat: Int = 0
     private var sampleRate: Int = 44100
     private var bitRate: Int = 128000
-    private val handler = Handler(Looper.getMainLooper())
+    // Metering polls run here rather than on the main looper, where they jitter with the UI
+    private val meteringThread = HandlerThread("AudioWaveformMetering").apply { start() }
+    private val handler = Handler(meteringThread.looper)
     private var startTime: Long = 0
+    // Values of the waveform the current PCM recording resolves with when stopped, 0 for none
+    private var waveformSamples = 0
+    private val peakCache by lazy {
+        PeakCache(File(reactApplicationContext.cacheDir, Constants.waveformCacheDirectory).path)
+    }
+    // Cache writes of finished extractions, off the decoder's callback thread
+    private val cacheExecutor = Executors.newSingleThreadExecutor()
 
     companion object {
         const val NAME = "AudioWaveform"
@@ -36,6 +51,19 @@ class AudioWaveformModule(context: ReactApplicationContext) : ReactContextBaseJa
 
     override fun getName(): String = NAME
 
+    override fun invalidate() {
+        pcmRecorder?.stop()
+        pcmRecorder = null
+        handler.removeCallbacksAndMessages(null)
+        meteringThread.quitSafely()
+        playbackTicker.release()
+        playerPool.clear()
+        extractionScheduler.release()
+        // Pending cache writes still finish
+        cacheExecutor.shutdown()
+        super.invalidate()
+    }
+
     @ReactMethod
     fun markPlayerAsUnmounted() {
         audioPlayers.values.forEach { it?.markPlayerAsUnmounted() }
@@ -58,15 +86,20 @@ class AudioWaveformModule(context: ReactApplicationContext) : ReactContextBaseJa
 
     @ReactMethod
     fun getDecibel(promise: Promise) {
-        val decibel = audioRecorder.getDecibel(recorder) ?: 0.0
+        val decibel = pcmRecorder?.lastLevel?.toDouble() ?: audioRecorder.getDecibel(recorder) ?: 0.0
         promise.resolve(decibel)
     }
 
     @ReactMethod
     fun startRecording(obj: ReadableMap?, promise: Promise) {
+        if (obj != null && obj.hasKey(Constants.engine) && obj.getString(Constants.engine) == Constants.pcmEngine) {
+            startPcmRecording(obj, promise)
+            return
+        }
         initRecorder(obj, promise)
         val useLegacyNormalization = true
         audioRecorder.startRecorder(recorder, useLegacyNormalization, promise)
+        LevelHistory.clear()
         startTime = System.currentTimeMillis()
         startEmittingRecorderValue()
     }
@@ -74,6 +107,11 @@ class AudioWaveformModule(context: ReactApplicationContext) : ReactContextBaseJa
     @RequiresApi(Build.VERSION_CODES.N)
     @ReactMethod
     fun pauseRecording(promise: Promise) {
+        pcmRecorder?.let {
+            it.isPaused = true
+            promise.resolve(true)
+            return
+        }
         audioRecorder.pauseRecording(recorder, promise)
         stopEmittingRecorderValue()
     }
@@ -81,12 +119,21 @@ class AudioWaveformModule(context: ReactApplicationContext) : ReactContextBaseJa
     @RequiresApi(Build.VERSION_CODES.N)
     @ReactMethod
     fun resumeRecording(promise: Promise) {
+        pcmRecorder?.let {
+            it.isPaused = false
+            promise.resolve(true)
+            return
+        }
         audioRecorder.resumeRecording(recorder, promise)
         startEmittingRecorderValue()
     }
 
     @ReactMethod
     fun stopRecording(promise: Promise) {
+        if (pcmRecorder != null) {
+            stopPcmRecording(promise)
+            return
+        }
         if (audioRecorder == null || recorder == null || path == null) {
             promise.reject("STOP_RECORDING_ERROR", "Recording resources not properly initialized")
             return
@@ -121,10 +168,14 @@ class AudioWaveformModule(context: ReactApplicationContext) : ReactContextBaseJa
         val frequency = obj.getInt(Constants.updateFrequency)
         val volume = obj.getInt(Constants.volume)
         val progress = if (!obj.hasKey(Constants.progress) || obj.isNull(Constants.progress)) 0 else obj.getInt(Constants.progress).toLong()
+        val interpolate = obj.hasKey(Constants.interpolatePosition) && obj.getBoolean(Constants.interpolatePosition)
+        val updateFrequency = if (interpolate) UpdateFrequency.Interpolated else getUpdateFrequency(frequency)
 
         if (key != null) {
             initPlayer(key)
-            audioPlayers[key]?.preparePlayer(path, volume, getUpdateFrequency(frequency), progress, promise)
+            PerfStats.trace("preparePlayer") {
+                audioPlayers[key]?.preparePlayer(path, volume, updateFrequency, progress, promise)
+            }
         } else {
             promise.reject(Constants.LOG_TAG, "Player key can't be null")
         }
@@ -184,17 +235,123 @@ class AudioWaveformModule(context: ReactApplicationContext) : ReactContextBaseJa
 
     @ReactMethod
     fun extractWaveformData(obj: ReadableMap, promise: Promise) {
-        val key = obj.getString(Constants.playerKey)
-        val path = obj.getString(Constants.path)
-        val noOfSamples = obj.getInt(Constants.noOfSamples)
-
-        if (key != null) {
-            createOrUpdateExtractor(key, noOfSamples, path, promise)
+        val request = ExtractionRequest.from(obj)
+        if (request != null) {
+            createOrUpdateExtractor(request, promiseResult(promise, request.binary))
         } else {
             Log.e(Constants.LOG_TAG, "Cannot get waveform data. Player key is null.")
         }
     }
 
+    /**
+     * [extractWaveformData] of several files in one call. Each item goes through the peak cache
+     * and the shared extraction scheduler like a single request, but sends no progress events,
+     * and the normalized waveforms resolve together in one payload: all values one after the
+     * other and the length of each, as a single WaveformJsi buffer with [Constants.binary]. Failed
+     * or cancelled items have length 0. Items need distinct player keys.
+     */
+    @ReactMethod
+    fun extractWaveformDataBatch(obj: ReadableMap, promise: Promise) {
+        val items = obj.getArray(Constants.items)
+        if (items == null) {
+            promise.reject("extractWaveformDataBatch Error", "No items provided")
+            return
+        }
+        val binary = obj.hasKey(Constants.binary) && obj.getBoolean(Constants.binary)
+        val results = arrayOfNulls<FloatArray>(items.size())
+        val isSettled = BooleanArray(items.size())
+        var remaining = items.size()
+        if (remaining == 0) {
+            resolveBatch(promise, results, binary)
+            return
+        }
+        // Items settle on the module's thread from the cache or on the scheduler's thread, a
+        // failing one may reject and then cancel as well
+        val lock = Any()
+        val complete = { index: Int, values: FloatArray? ->
+            synchronized(lock) {
+                if (isSettled[index]) return@synchronized
+                isSettled[index] = true
+                results[index] = values
+                if (--remaining == 0) resolveBatch(promise, results, binary)
+            }
+        }
+        for (index in 0 until items.size()) {
+            val request = items.getMap(index)?.let { ExtractionRequest.from(it) }
+            if (request == null) {
+                complete(index, null)
+                continue
+            }
+            val batchRequest = request.copy(progressMode = ProgressMode.None, binary = false, withPeaks = false, preview = false)
+            createOrUpdateExtractor(batchRequest, object : ExtractionResult {
+                override fun resolve(rms: FloatArray, peaks: FloatArray?) = complete(index, rms)
+
+                override fun reject(code: String, message: String?) {
+                    Log.e(Constants.LOG_TAG, "Batch extraction of ${request.path} failed: $code $message")
+                    complete(index, null)
+                }
+
+                override fun cancel() = complete(index, null)
+            })
+        }
+    }
+
+    /**
+     * [preparePlayer] and [extractWaveformData] of the same file in one call, with the arguments
+     * of both. The player prepares while the extraction decodes instead of after it, and the
+     * promise resolves with the waveform and the player's duration once both are done.
+     */
+    @ReactMethod
+    fun prepareWithWaveform(obj: ReadableMap, promise: Promise) {
+        if (obj.getString(Constants.playerKey) == null) {
+            promise.reject("prepareWithWaveform Error", "Player key can't be null")
+            return
+        }
+        val result = Arguments.createMap()
+        var remaining = 2
+        var isSettled = false
+        // The extraction settles on the scheduler's thread, the player on its looper
+        val lock = Any()
+        val complete = { fill: (WritableMap) -> Unit ->
+            synchronized(lock) {
+                if (!isSettled) {
+                    fill(result)
+                    if (--remaining == 0) {
+                        isSettled = true
+                        promise.resolve(result)
+                    }
+                }
+            }
+        }
+        val errorOf = { args: Array<Any?> -> args.firstOrNull() as? ReadableMap }
+        // Only a failed extraction rejects, without a waveform there is nothing to show
+        val fail = Callback { args ->
+            synchronized(lock) {
+                if (!isSettled) {
+                    isSettled = true
+                    val error = errorOf(args)
+                    val code = error?.takeIf { it.hasKey("code") }?.getString("code")
+                    val message = error?.takeIf { it.hasKey("message") }?.getString("message")
+                    promise.reject(code ?: "prepareWithWaveform Error", message)
+                }
+            }
+        }
+        extractWaveformData(obj, PromiseImpl({ args ->
+            complete { it.putArray(Constants.waveformData, args.firstOrNull() as? ReadableArray) }
+        }, fail))
+        preparePlayer(obj, PromiseImpl({ args ->
+            val duration = (args.firstOrNull() as? String)?.toDoubleOrNull() ?: -1.0
+            complete { it.putDouble(Constants.duration, duration) }
+        }, { args ->
+            // e.g. too many players, the waveform is still drawn and the player prepared on play
+            val message = errorOf(args)?.takeIf { it.hasKey("message") }?.getString("message")
+            complete {
+                it.putDouble(Constants.duration, -1.0)
+                it.putString(Constants.playerError, message ?: "Could not prepare the player")
+            }
+        }))
+    }
+
     @ReactMethod
     fun stopAllPlayers(promise: Promise) {
         try {
@@ -209,14 +366,71 @@ class AudioWaveformModule(context: ReactApplicationContext) : ReactContextBaseJa
     @ReactMethod
     fun stopAllWaveFormExtractors(promise: Promise) {
         try {
-            extractors.values.forEach { it?.forceStop() }
-            extractors.clear()
+            extractionScheduler.cancelAll()
             promise.resolve(true)
         } catch (err: Exception) {
             promise.reject("stopAllExtractors Error", "Error while stopping all extractors")
         }
     }
 
+    @ReactMethod(isBlockingSynchronousMethod = true)
+    fun installJSIBindings(): Boolean {
+        return try {
+            WaveformJsi.install(reactApplicationContext.javaScriptContextHolder?.get() ?: 0L)
+        } catch (e: Exception) {
+            Log.e(Constants.LOG_TAG, "Failed to install the JSI bindings", e)
+            false
+        }
+    }
+
+    @ReactMethod
+    fun cancelWaveformExtraction(obj: ReadableMap, promise: Promise) {
+        val key = obj.getString(Constants.playerKey)
+        if (key == null) {
+            promise.reject("cancelWaveformExtraction Error", "Player key can't be null")
+            return
+        }
+        promise.resolve(extractionScheduler.cancel(key))
+    }
+
+    @ReactMethod
+    fun prefetchPlayer(obj: ReadableMap, promise: Promise) {
+        val path = obj.getString(Constants.path)
+        if (path.isNullOrEmpty()) {
+            promise.reject("prefetchPlayer Error", "path to audio file can't be null")
+            return
+        }
+        try {
+            promise.resolve(playerPool.prefetch(path))
+        } catch (e: Exception) {
+            promise.reject("prefetchPlayer Error", e.toString())
+        }
+    }
+
+    @ReactMethod
+    fun setMaxConcurrentExtractions(obj: ReadableMap, promise: Promise) {
+        if (!obj.hasKey(Constants.maxConcurrentExtractions) || obj.isNull(Constants.maxConcurrentExtractions)) {
+            promise.reject("setMaxConcurrentExtractions Error", "maxConcurrentExtractions can't be null")
+            return
+        }
+        extractionScheduler.maxConcurrent = obj.getInt(Constants.maxConcurrentExtractions)
+        promise.resolve(extractionScheduler.maxConcurrent)
+    }
+
+    /** Turns the PerfStats counters on or off. Turning them off keeps what was counted. */
+    @ReactMethod
+    fun setPerfStatsEnabled(obj: ReadableMap, promise: Promise) {
+        PerfStats.isEnabled = obj.hasKey(Constants.enabled) && obj.getBoolean(Constants.enabled)
+        promise.resolve(PerfStats.isEnabled)
+    }
+
+    /** The PerfStats counters by player key, cleared afterwards with [Constants.reset] */
+    @ReactMethod
+    fun getPerfStats(obj: ReadableMap?, promise: Promise) {
+        val reset = obj != null && obj.hasKey(Constants.reset) && obj.getBoolean(Constants.reset)
+        promise.resolve(PerfStats.snapshot(reset))
+    }
+
     @ReactMethod
     fun setPlaybackSpeed(obj: ReadableMap, promise: Promise) {
         try {
@@ -235,57 +449,150 @@ class AudioWaveformModule(context: ReactApplicationContext) : ReactContextBaseJa
 
     private fun initPlayer(playerKey: String) {
         if (audioPlayers[playerKey] == null) {
-            val newPlayer = AudioPlayer(reactApplicationContext, playerKey)
+            val newPlayer = AudioPlayer(reactApplicationContext, playerKey, playbackTicker, playerPool)
             audioPlayers[playerKey] = newPlayer
         }
     }
 
-    private fun createOrUpdateExtractor(playerKey: String, noOfSamples: Int, path: String?, promise: Promise) {
+    private fun createOrUpdateExtractor(request: ExtractionRequest, result: ExtractionResult) {
+        val playerKey = request.playerKey
+        val noOfSamples = request.noOfSamples
+        val downloadPath = request.downloadPath
+        val scale = request.scale
+        val threshold = request.threshold
+        val path = request.path
         if (path == null) {
-            promise.reject("createOrUpdateExtractor Error", "No path provided")
+            result.reject("createOrUpdateExtractor Error", "No path provided")
             return
         }
+        // A remote file downloaded before is read locally, where the peak cache applies again
+        val isDownloaded = HttpRangeDataSource.isRemote(path) && downloadPath != null && File(downloadPath).exists()
+        val source = if (isDownloaded) downloadPath!! else path
+        val isRemote = HttpRangeDataSource.isRemote(source)
+        // The peak cache only holds mixdown values
+        val useCache = request.useCache && request.channelMode == ChannelMode.Mixdown
+
+        if (useCache) {
+            peakCache.load(source, noOfSamples)?.let { (rms, peaks) ->
+                PerfStats.record(playerKey) { cacheHits++ }
+                WaveformReducer.normalize(rms, WaveformReducer.normalizationMax(rms, threshold), scale, threshold)
+                result.resolve(rms, if (request.withPeaks) peaks else null)
+                return
+            }
+            PerfStats.record(playerKey) { cacheMisses++ }
+        }
 
-        extractors[playerKey] = WaveformExtractor(
-            context = reactApplicationContext,
-            path = path,
-            expectedPoints = noOfSamples,
-            key = playerKey,
-            extractorCallBack = object : ExtractorCallBack {
-                override fun onProgress(value: Float) {
-                    if (value == 1.0F) {
-                        extractors[playerKey]?.sampleData?.let { data ->
-                            val normalizedData = normalizeWaveformData(data, 0.12f)
-                            val output: MutableList<MutableList<Float>> = mutableListOf(normalizedData)
-                            promise.resolve(Arguments.fromList(output))
+        extractionScheduler.submit(playerKey, request.priority, start = { finish ->
+            lateinit var extractor: WaveformExtractor
+            extractor = WaveformExtractor(
+                context = reactApplicationContext,
+                path = source,
+                expectedPoints = noOfSamples,
+                key = playerKey,
+                withPeaks = request.withPeaks,
+                // The peak cache is keyed by file stats, a URL has none
+                buildPyramid = useCache && !isRemote,
+                progressMode = request.progressMode,
+                progressIntervalMs = request.progressIntervalMs,
+                binary = request.binary,
+                downloadPath = if (isRemote) downloadPath else null,
+                channelMode = request.channelMode,
+                preview = request.preview,
+                threshold = threshold,
+                extractorCallBack = object : ExtractorCallBack {
+                    override fun onProgress(value: Float) {
+                        if (value == 1.0F) {
+                            val isCached = useCache && !isRemote
+                            // Copied before the values are scaled in place
+                            val rms = if (isCached) extractor.sampleData.copyOf() else null
+                            val peaks = if (isCached) extractor.peakData.copyOf() else null
+                            val pyramid = if (isCached) extractor.takePyramid() else null
+                            val normalizedData = extractor.resultData
+                            WaveformReducer.normalize(normalizedData, extractor.normalizationMax, scale, threshold)
+                            // Peaks are returned un-normalized, as full-scale amplitudes
+                            result.resolve(normalizedData, if (extractor.withPeaks) extractor.resultPeaks else null)
+                            onFinished()
+                            if (rms != null && peaks != null) {
+                                cacheExecutor.execute {
+                                    peakCache.store(source, rms, peaks, pyramid)
+                                    pyramid?.release()
+                                }
+                            }
                         }
                     }
-                }
 
-                override fun onReject(error: String?, message: String?) {
-                    promise.reject(error ?: "Error", message ?: "Waveform decoding error")
-                }
+                    override fun onReject(error: String?, message: String?) {
+                        result.reject(error ?: "Error", message ?: "Waveform decoding error")
+                        onFinished()
+                    }
+
+                    override fun onResolve(rms: FloatArray, peaks: FloatArray?) {
+                        WaveformReducer.normalize(rms, extractor.normalizationMax, scale, threshold)
+                        result.resolve(rms, peaks)
+                        onFinished()
+                    }
+
+                    override fun onForceStop() {
+                        result.cancel()
+                        onFinished()
+                    }
 
-                override fun onResolve(value: MutableList<MutableList<Float>>) {
-                    promise.resolve(Arguments.fromList(value))
+                    private fun onFinished() {
+                        finish()
+                    }
                 }
+            )
+            extractor.startDecode()
+            extractor::forceStop
+        }, onCancel = {
+            result.cancel()
+        }, onError = { e ->
+            result.reject("extractWaveform Error", e.message ?: "Could not start the extraction")
+        })
+    }
 
-                override fun onForceStop() {
-                    promise.resolve(Arguments.fromList(mutableListOf(emptyList<Float>())))
+    /**
+     * Resolves [promise] with the normalized values and, when requested, the peaks as bridge
+     * arrays, or with [binary] as the ids of WaveformJsi buffers that JS takes as Float32Arrays.
+     * A stopped extraction resolves one empty array, in binary mode as the id of an empty buffer.
+     */
+    private fun promiseResult(promise: Promise, binary: Boolean) = object : ExtractionResult {
+        override fun resolve(rms: FloatArray, peaks: FloatArray?) {
+            val output = Arguments.createArray()
+            for (values in listOfNotNull(rms, peaks)) {
+                if (binary) {
+                    output.pushDouble(WaveformJsi.putBuffer(values, isResult = true).toDouble())
+                } else {
+                    output.pushArray(toWritableArray(values, 0, values.size))
                 }
             }
-        )
-        extractors[playerKey]?.startDecode()
+            promise.resolve(output)
+        }
+
+        override fun reject(code: String, message: String?) = promise.reject(code, message)
+
+        override fun cancel() = resolve(FloatArray(0), null)
     }
 
-    private fun normalizeWaveformData(data: MutableList<Float>, scale: Float = 0.25f, threshold: Float = 0.01f): MutableList<Float> {
-        val filtered = data.filter { kotlin.math.abs(it) >= threshold }
-        val maxAmp = filtered.maxOrNull() ?: 1.0f
-        return if (maxAmp > 0) {
-            data.map { if (kotlin.math.abs(it) < threshold) 0.0f else (it / maxAmp) * scale }.toMutableList()
+    /** Resolves the values of all [results] one after the other with the length of each */
+    private fun resolveBatch(promise: Promise, results: Array<FloatArray?>, binary: Boolean) {
+        val values = FloatArray(results.sumOf { it?.size ?: 0 })
+        val lengths = Arguments.createArray()
+        var offset = 0
+        for (result in results) {
+            val count = result?.size ?: 0
+            result?.copyInto(values, offset)
+            offset += count
+            lengths.pushInt(count)
+        }
+        val payload = Arguments.createMap()
+        payload.putArray(Constants.lengths, lengths)
+        if (binary) {
+            payload.putDouble(Constants.bufferId, WaveformJsi.putBuffer(values, isResult = true).toDouble())
         } else {
-            data
+            payload.putArray(Constants.waveformData, toWritableArray(values, 0, values.size))
         }
+        promise.resolve(payload)
     }
 
     private fun getUpdateFrequency(freq: Int?): UpdateFrequency {
@@ -296,6 +603,87 @@ class AudioWaveformModule(context: ReactApplicationContext) : ReactContextBaseJa
         }
     }
 
+    private fun startPcmRecording(obj: ReadableMap, promise: Promise) {
+        if (pcmRecorder != null) {
+            promise.reject("RECORDING_ERROR", "A recording is already in progress")
+            return
+        }
+        val sampleRateVal = if (obj.hasKey(Constants.sampleRate)) obj.getInt(Constants.sampleRate) else sampleRate
+        val bitRateVal = if (obj.hasKey(Constants.bitRate)) obj.getInt(Constants.bitRate) else bitRate
+        val outputPath = createRecordingPathIfNeeded()
+        if (outputPath == null) {
+            promise.reject("RECORDING_ERROR", "Failed to create the recording file")
+            return
+        }
+        waveformSamples = if (obj.hasKey(Constants.waveformSamples) && !obj.isNull(Constants.waveformSamples)) obj.getInt(Constants.waveformSamples) else 0
+        val engine = PcmRecorder(outputPath, sampleRateVal, bitRateVal, UpdateFrequency.Low.value, peakCache) { levels ->
+            // Called on the recording thread, one event per batch
+            levels.forEach { LevelHistory.push(it) }
+            val args: WritableMap = Arguments.createMap()
+            args.putDouble(Constants.currentDecibel, levels.last().toDouble())
+            args.putArray(Constants.levels, Arguments.fromArray(levels.map { it.toDouble() }.toDoubleArray()))
+            reactApplicationContext
+                .getJSModule(DeviceEventManagerModule.RCTDeviceEventEmitter::class.java)
+                ?.emit(Constants.onCurrentRecordingWaveformData, args)
+        }
+        try {
+            LevelHistory.clear()
+            engine.start()
+            pcmRecorder = engine
+            startTime = System.currentTimeMillis()
+            promise.resolve(true)
+        } catch (e: Exception) {
+            Log.e(Constants.LOG_TAG, "Failed to start PCM recording", e)
+            path = null
+            promise.reject("RECORDING_ERROR", "Failed to start recording: ${e.message}")
+        }
+    }
+
+    private fun stopPcmRecording(promise: Promise) {
+        val engine = pcmRecorder ?: return
+        if (System.currentTimeMillis() - startTime < 500) {
+            promise.reject("SHORT_RECORDING", "Recording is too short")
+            return
+        }
+        pcmRecorder = null
+        val duration = engine.stop()
+        val outputPath = path
+        path = null
+        if (duration < 0 || outputPath == null) {
+            promise.reject("Error", "Failed to stop recording: nothing was recorded")
+            return
+        }
+        val result = Arguments.createArray()
+        result.pushString(outputPath)
+        result.pushString(duration.toString())
+        // Served from the pyramid the recorder stored, normalized like extractWaveformData
+        val waveform = if (waveformSamples > 0) peakCache.load(outputPath, waveformSamples)?.firstOrNull() else null
+        if (waveform != null) {
+            WaveformReducer.normalize(
+                waveform,
+                WaveformReducer.normalizationMax(waveform, DEFAULT_NORMALIZATION_THRESHOLD),
+                DEFAULT_NORMALIZATION_SCALE,
+                DEFAULT_NORMALIZATION_THRESHOLD
+            )
+            result.pushArray(toWritableArray(waveform, 0, waveform.size))
+        }
+        promise.resolve(result)
+    }
+
+    private fun createRecordingPathIfNeeded(): String? {
+        if (path == null) {
+            val outputDir = reactApplicationContext.currentActivity?.cacheDir
+            val date = SimpleDateFormat(Constants.fileNameFormat, Locale.US).format(Date())
+            try {
+                val file = File.createTempFile(date, ".m4a", outputDir)
+                path = file.path
+            } catch (e: IOException) {
+                Log.e(Constants.LOG_TAG, "Failed to create file")
+            }
+        }
+        return path
+    }
+
     private fun checkPathAndInitialiseRecorder(
         encoder: Int,
         outputFormat: Int,
@@ -318,18 +706,7 @@ class AudioWaveformModule(context: ReactApplicationContext) : ReactContextBaseJa
             Log.e(Constants.LOG_TAG, "Failed to initialize recorder")
         }
 
-        if (path == null) {
-            val outputDir = reactApplicationContext.currentActivity?.cacheDir
-            val date = SimpleDateFormat(Constants.fileNameFormat, Locale.US).format(Date())
-            try {
-                val file = File.createTempFile(date, ".m4a", outputDir)
-                path = file.path
-            } catch (e: IOException) {
-                Log.e(Constants.LOG_TAG, "Failed to create file")
-            }
-        }
-
-        path?.let {
+        createRecordingPathIfNeeded()?.let {
             audioRecorder.initRecorder(it, recorder, encoder, outputFormat, sampleRateVal, bitRateVal, promise)
         }
     }
@@ -337,8 +714,10 @@ class AudioWaveformModule(context: ReactApplicationContext) : ReactContextBaseJa
     private val emitLiveRecordValue = object : Runnable {
         override fun run() {
             val decibel = audioRecorder.getDecibel(recorder) ?: 0.0
+            val level = if (decibel == Double.NEGATIVE_INFINITY) 0.0 else decibel / 1000
+            LevelHistory.push(level.toFloat())
             val args: WritableMap = Arguments.createMap()
-            args.putDouble(Constants.currentDecibel, if (decibel == Double.NEGATIVE_INFINITY) 0.0 else decibel / 1000)
+            args.putDouble(Constants.currentDecibel, level)
             handler.postDelayed(this, UpdateFrequency.Low.value)
             reactApplicationContext
                 .getJSModule(DeviceEventManagerModule.RCTDeviceEventEmitter::class.java)
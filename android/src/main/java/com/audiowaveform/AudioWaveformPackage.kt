@@ -12,6 +12,6 @@ class AudioWaveformPackage : ReactPackage {
   }
 
   override fun createViewManagers(reactContext: ReactApplicationContext): List<ViewManager<*, *>> {
-    return emptyList()
+    return listOf(WaveformViewManager())
   }
 }
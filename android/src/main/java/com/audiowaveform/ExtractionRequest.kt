@@ -0,0 +1,59 @@
+package com.audiowaveform
+
+import com.facebook.react.bridge.ReadableMap
+
+/** The options of one waveform extraction, as IExtractWaveform passes them */
+data class ExtractionRequest(
+    val playerKey: String,
+    val path: String?,
+    val noOfSamples: Int,
+    val withPeaks: Boolean,
+    val useCache: Boolean,
+    val priority: Int,
+    val progressMode: ProgressMode,
+    val progressIntervalMs: Long,
+    val binary: Boolean,
+    val downloadPath: String?,
+    val channelMode: ChannelMode,
+    val preview: Boolean,
+    val scale: Float,
+    val threshold: Float,
+) {
+    companion object {
+        /** Null without a player key */
+        fun from(obj: ReadableMap): ExtractionRequest? {
+            val playerKey = obj.getString(Constants.playerKey) ?: return null
+            val binary = obj.hasKey(Constants.binary) && obj.getBoolean(Constants.binary)
+            return ExtractionRequest(
+                playerKey = playerKey,
+                path = obj.getString(Constants.path),
+                noOfSamples = obj.getInt(Constants.noOfSamples),
+                withPeaks = obj.hasKey(Constants.withPeaks) && obj.getBoolean(Constants.withPeaks),
+                useCache = !obj.hasKey(Constants.useCache) || obj.getBoolean(Constants.useCache),
+                priority = if (obj.hasKey(Constants.priority) && !obj.isNull(Constants.priority)) obj.getInt(Constants.priority) else 0,
+                // Binary progress events are always deltas, a full copy per bucket would defeat the point
+                progressMode = if (binary) ProgressMode.Delta else ProgressMode.from(if (obj.hasKey(Constants.progressMode)) obj.getString(Constants.progressMode) else null),
+                progressIntervalMs = if (obj.hasKey(Constants.progressInterval) && !obj.isNull(Constants.progressInterval)) {
+                    obj.getDouble(Constants.progressInterval).toLong().coerceAtLeast(0)
+                } else {
+                    DEFAULT_PROGRESS_INTERVAL_MS
+                },
+                binary = binary,
+                downloadPath = if (obj.hasKey(Constants.downloadPath) && !obj.isNull(Constants.downloadPath)) obj.getString(Constants.downloadPath) else null,
+                channelMode = ChannelMode.from(if (obj.hasKey(Constants.channelMode)) obj.getString(Constants.channelMode) else null),
+                preview = obj.hasKey(Constants.preview) && obj.getBoolean(Constants.preview),
+                scale = if (obj.hasKey(Constants.scale) && !obj.isNull(Constants.scale)) obj.getDouble(Constants.scale).toFloat() else DEFAULT_NORMALIZATION_SCALE,
+                threshold = if (obj.hasKey(Constants.threshold) && !obj.isNull(Constants.threshold)) obj.getDouble(Constants.threshold).toFloat() else DEFAULT_NORMALIZATION_THRESHOLD,
+            )
+        }
+    }
+}
+
+/** Where the outcome of an extraction goes: a request's promise, or its slot in a batch */
+interface ExtractionResult {
+    /** [rms] is normalized, [peaks] are only given when requested */
+    fun resolve(rms: FloatArray, peaks: FloatArray?)
+    fun reject(code: String, message: String?)
+    /** The extraction was stopped or cancelled before it finished */
+    fun cancel()
+}
@@ -0,0 +1,173 @@
+package com.audiowaveform
+
+import android.media.MediaCodecList
+import android.media.MediaFormat
+import android.os.Build
+import android.os.Handler
+import android.os.HandlerThread
+import java.util.PriorityQueue
+import java.util.concurrent.atomic.AtomicBoolean
+
+/**
+ * Runs waveform extractions with at most [maxConcurrent] MediaCodec decoders alive at once.
+ * Pending jobs start by descending priority, then in submission order. Jobs are started on a
+ * dedicated thread, which also becomes the callback looper of the decoders they create. A job
+ * is tracked from the moment it leaves the queue, so it can be cancelled before it started too.
+ */
+class ExtractionScheduler(maxConcurrent: Int = defaultMaxConcurrent()) {
+    private class Job(
+        val key: String,
+        val priority: Int,
+        val order: Long,
+        val start: (finish: () -> Unit) -> () -> Unit,
+        val onCancel: () -> Unit,
+        val onError: (Exception) -> Unit,
+        val submittedNanos: Long = System.nanoTime()
+    ) {
+        // Guarded by the scheduler. A cancelled job that did not start yet never does
+        var isCancelled = false
+        // What start returned, null until it returns
+        var stop: (() -> Unit)? = null
+    }
+
+    private val pending = PriorityQueue<Job>(
+        compareByDescending<Job> { it.priority }.thenBy { it.order }
+    )
+    // Jobs taken from pending, whether started yet or not, until they finish
+    private val running = mutableListOf<Job>()
+    private var submitted = 0L
+    private val thread = HandlerThread("AudioWaveformExtraction").apply { start() }
+    private val handler = Handler(thread.looper)
+
+    var maxConcurrent: Int = maxConcurrent.coerceAtLeast(1)
+        @Synchronized set(value) {
+            field = value.coerceAtLeast(1)
+            drain()
+        }
+
+    /**
+     * Queues [start] for [key]. It returns the function that stops what it started, and must
+     * call the given `finish` once its extraction resolved, rejected or was stopped, to free the
+     * slot. A job pending or running for [key] is replaced: a pending one receives
+     * [Job.onCancel], a running one is stopped. If [start] throws, the slot is freed and [onError]
+     * settles the job.
+     */
+    fun submit(
+        key: String,
+        priority: Int,
+        start: (finish: () -> Unit) -> () -> Unit,
+        onCancel: () -> Unit,
+        onError: (Exception) -> Unit,
+    ) {
+        val stops = synchronized(this) {
+            cancelWhere { it.key == key }.also {
+                pending.add(Job(key, priority, submitted++, start, onCancel, onError))
+                drain()
+            }
+        }
+        stops.forEach { it() }
+    }
+
+    /** Cancels the pending and running jobs of [key]. Returns true if there were any. */
+    fun cancel(key: String): Boolean {
+        var found = false
+        val stops = synchronized(this) {
+            found = pending.any { it.key == key } || running.any { it.key == key && !it.isCancelled }
+            cancelWhere { it.key == key }
+        }
+        stops.forEach { it() }
+        return found
+    }
+
+    fun cancelAll() {
+        val stops = synchronized(this) { cancelWhere { true } }
+        stops.forEach { it() }
+    }
+
+    /**
+     * Settles the pending jobs that [matches] with [Job.onCancel] and marks the running ones
+     * cancelled. Returns the stops of those already started, to call outside the lock: a
+     * stopping decoder may be finishing its job on another thread, which takes the lock.
+     */
+    private fun cancelWhere(matches: (Job) -> Boolean): List<() -> Unit> {
+        val cancelled = pending.filter(matches)
+        pending.removeAll(cancelled.toSet())
+        cancelled.forEach { it.onCancel() }
+        return running.filter { matches(it) && !it.isCancelled }.mapNotNull { job ->
+            job.isCancelled = true
+            job.stop
+        }
+    }
+
+    private fun drain() {
+        while (running.size < maxConcurrent) {
+            val job = pending.poll() ?: return
+            running.add(job)
+            val finished = AtomicBoolean(false)
+            val finish = {
+                if (finished.compareAndSet(false, true)) onFinished(job)
+            }
+            handler.post { run(job, finish) }
+        }
+    }
+
+    private fun run(job: Job, finish: () -> Unit) {
+        PerfStats.record(job.key) { queueWaitMs += PerfStats.elapsedMs(job.submittedNanos) }
+        synchronized(this) {
+            if (job.isCancelled) {
+                finish()
+                job.onCancel()
+                return
+            }
+        }
+        val stop = try {
+            job.start(finish)
+        } catch (e: Exception) {
+            finish()
+            job.onError(e)
+            return
+        }
+        // A cancel that came while starting found no stop to call yet
+        val isCancelled = synchronized(this) {
+            job.stop = stop
+            job.isCancelled
+        }
+        if (isCancelled) stop()
+    }
+
+    @Synchronized
+    private fun onFinished(job: Job) {
+        running.remove(job)
+        drain()
+    }
+
+    fun release() {
+        cancelAll()
+        thread.quitSafely()
+    }
+
+    companion object {
+        // Software decoding of many files at once mostly buys thermal throttling
+        private const val MAX_DEFAULT_CONCURRENT = 4
+
+        /**
+         * The number of concurrent AAC decoder instances the device reports, bounded by half
+         * the CPU cores and [MAX_DEFAULT_CONCURRENT].
+         */
+        fun defaultMaxConcurrent(): Int {
+            val cores = maxOf(1, Runtime.getRuntime().availableProcessors() / 2)
+            val codecInstances = if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.M) {
+                try {
+                    MediaCodecList(MediaCodecList.REGULAR_CODECS).codecInfos
+                        .filter { !it.isEncoder && it.supportedTypes.contains(MediaFormat.MIMETYPE_AUDIO_AAC) }
+                        .maxOfOrNull { it.getCapabilitiesForType(MediaFormat.MIMETYPE_AUDIO_AAC).maxSupportedInstances }
+                } catch (e: Exception) {
+                    null
+                }
+            } else {
+                null
+            }
+            return minOf(codecInstances ?: MAX_DEFAULT_CONCURRENT, cores, MAX_DEFAULT_CONCURRENT).coerceAtLeast(1)
+        }
+    }
+}
@@ -0,0 +1,172 @@
+package com.audiowaveform
+
+import android.media.MediaDataSource
+import android.os.Build
+import android.util.Log
+import androidx.annotation.RequiresApi
+import java.io.File
+import java.io.IOException
+import java.io.InputStream
+import java.io.RandomAccessFile
+import java.net.HttpURLConnection
+import java.net.URL
+import java.util.BitSet
+
+/**
+ * Lets MediaExtractor read an HTTP(S) file while it downloads. Bytes are fetched in blocks into a
+ * sparse part file and served from there, so the decoder starts on the first blocks and reads
+ * again (e.g. a trailing moov atom and back) never hit the network twice. Sequential reads share
+ * one open-ended range request; a jump opens a new one at the wanted block.
+ *
+ * With a [downloadPath], the part file is completed in the background once the source is closed
+ * and moved there, so the player can play the local copy.
+ */
+@RequiresApi(Build.VERSION_CODES.M)
+class HttpRangeDataSource(
+    private val url: String,
+    private val downloadPath: String?,
+    cacheDirectory: File
+) : MediaDataSource() {
+    private val partFile = if (downloadPath != null) File("$downloadPath.part") else File.createTempFile("waveform", ".part", cacheDirectory)
+    private val file = RandomAccessFile(partFile, "rw")
+    private val fetched = BitSet()
+    private val block = ByteArray(BLOCK_SIZE)
+    private var totalSize = -1L
+    private var connection: HttpURLConnection? = null
+    private var stream: InputStream? = null
+    // Block aligned offset of the next byte of stream
+    private var streamPosition = 0L
+    private var supportsRanges = true
+    private var isClosed = false
+
+    @Synchronized
+    override fun getSize(): Long {
+        if (totalSize < 0) open(0)
+        return totalSize
+    }
+
+    @Synchronized
+    override fun readAt(position: Long, buffer: ByteArray, offset: Int, size: Int): Int {
+        if (isClosed) throw IOException("Data source is closed")
+        val total = getSize()
+        if (position >= total) return -1
+        val length = minOf(size.toLong(), total - position).toInt()
+        if (length <= 0) return 0
+        fill(position, position + length)
+        file.seek(position)
+        file.readFully(buffer, offset, length)
+        return length
+    }
+
+    @Synchronized
+    override fun close() {
+        if (isClosed) return
+        isClosed = true
+        if (downloadPath == null) {
+            release(deletePart = true)
+            return
+        }
+        Thread({ completeDownload(downloadPath) }, "AudioWaveformDownload").start()
+    }
+
+    private fun completeDownload(target: String) = synchronized(this) {
+        try {
+            fill(0, getSize())
+            release(deletePart = false)
+            if (!partFile.renameTo(File(target))) throw IOException("Failed to move the download to $target")
+        } catch (e: IOException) {
+            Log.e(Constants.LOG_TAG, "Failed to download $url", e)
+            release(deletePart = true)
+        }
+    }
+
+    /** Makes sure the bytes from [from] until [to] are in the part file. */
+    private fun fill(from: Long, to: Long) {
+        var index = (from / BLOCK_SIZE).toInt()
+        val last = ((to - 1) / BLOCK_SIZE).toInt()
+        while (index <= last) {
+            if (fetched[index]) {
+                index++
+                continue
+            }
+            val start = index.toLong() * BLOCK_SIZE
+            // Keep reading the open stream for sequential reads and short jumps ahead, the
+            // blocks skipped on the way are kept as well
+            val gap = start - streamPosition
+            if (stream == null || gap < 0 || (supportsRanges && gap > MAX_STREAM_SKIP)) open(start)
+            while (streamPosition <= start) readBlock()
+            index++
+        }
+    }
+
+    private fun readBlock() {
+        val input = stream ?: throw IOException("No open stream")
+        val expected = minOf(BLOCK_SIZE.toLong(), totalSize - streamPosition).toInt()
+        var read = 0
+        while (read < expected) {
+            val count = input.read(block, read, expected - read)
+            if (count < 0) throw IOException("Unexpected end of $url at ${streamPosition + read}")
+            read += count
+        }
+        file.seek(streamPosition)
+        file.write(block, 0, read)
+        fetched.set((streamPosition / BLOCK_SIZE).toInt())
+        streamPosition += read
+    }
+
+    /** Opens a range request from [position] on, or the whole file if the server ignores ranges. */
+    private fun open(position: Long) {
+        closeStream()
+        val opened = URL(url).openConnection() as HttpURLConnection
+        opened.connectTimeout = TIMEOUT_MS
+        opened.readTimeout = TIMEOUT_MS
+        opened.setRequestProperty("Range", "bytes=$position-")
+        val code = opened.responseCode
+        if (code != HttpURLConnection.HTTP_OK && code != HttpURLConnection.HTTP_PARTIAL) {
+            opened.disconnect()
+            throw IOException("HTTP $code for $url")
+        }
+        supportsRanges = code == HttpURLConnection.HTTP_PARTIAL
+        if (totalSize < 0) {
+            // Content-Range is "bytes first-last/total"
+            totalSize = if (supportsRanges) {
+                opened.getHeaderField("Content-Range")?.substringAfterLast('/')?.toLongOrNull() ?: -1L
+            } else {
+                opened.getHeaderField("Content-Length")?.toLongOrNull() ?: -1L
+            }
+            if (totalSize < 0) {
+                opened.disconnect()
+                throw IOException("Unknown length of $url")
+            }
+        }
+        connection = opened
+        stream = opened.inputStream.buffered(BLOCK_SIZE)
+        streamPosition = if (supportsRanges) position else 0L
+    }
+
+    private fun closeStream() {
+        try {
+            stream?.close()
+        } catch (e: IOException) {
+            // The connection is dropped anyway
+        }
+        connection?.disconnect()
+        stream = null
+        connection = null
+    }
+
+    private fun release(deletePart: Boolean) {
+        closeStream()
+        file.close()
+        if (deletePart) partFile.delete()
+    }
+
+    companion object {
+        private const val BLOCK_SIZE = 64 * 1024
+        // Jumps further ahead than this start a new request rather than downloading the gap
+        private const val MAX_STREAM_SKIP = 1024 * 1024L
+        private const val TIMEOUT_MS = 15_000
+
+        fun isRemote(path: String) = path.startsWith("http://", ignoreCase = true) || path.startsWith("https://", ignoreCase = true)
+    }
+}
@@ -0,0 +1,18 @@
+package com.audiowaveform
+
+/**
+ * The native ring buffer of live recording levels (cpp/LevelHistory.h). JS reads the tail it
+ * shows through `global.__AudioWaveformJsi.recordingLevels` instead of keeping the history.
+ */
+object LevelHistory {
+    init {
+        System.loadLibrary("audiowaveform")
+    }
+
+    fun push(level: Float) = nativePush(level)
+
+    fun clear() = nativeClear()
+
+    private external fun nativePush(level: Float)
+    private external fun nativeClear()
+}
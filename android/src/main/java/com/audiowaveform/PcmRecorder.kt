@@ -0,0 +1,238 @@
+package com.audiowaveform
+
+import android.annotation.SuppressLint
+import android.media.AudioFormat
+import android.media.AudioRecord
+import android.media.MediaCodec
+import android.media.MediaCodecInfo
+import android.media.MediaFormat
+import android.media.MediaMuxer
+import android.media.MediaRecorder
+import android.os.Process
+import android.util.Log
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+import kotlin.math.log10
+
+/**
+ * Recording engine on AudioRecord and a MediaCodec AAC encoder, muxed into an MPEG-4 file.
+ * Unlike MediaRecorder it sees the PCM, so a level is measured for every 10 ms frame on the
+ * audio thread with the shared reduction kernel, and handed to [onLevels] in batches of
+ * [batchIntervalMs] from that thread. The same PCM feeds a [PeakPyramid], which is stored in
+ * [peakCache] once the file is finished, so extracting the new recording's waveform does not
+ * decode it again.
+ */
+class PcmRecorder(
+    private val path: String,
+    private val sampleRate: Int,
+    private val bitRate: Int,
+    private val batchIntervalMs: Long,
+    private val peakCache: PeakCache?,
+    private val onLevels: (levels: FloatArray) -> Unit
+) {
+    private val framesPerLevel = maxOf(1, sampleRate / LEVELS_PER_SECOND)
+    private var thread: Thread? = null
+    @Volatile private var isRunning = false
+
+    /** Frames are still read while paused, but neither encoded nor metered */
+    @Volatile var isPaused = false
+
+    /** The newest level, on the same scale as the legacy MediaRecorder levels */
+    @Volatile var lastLevel = 0f
+        private set
+
+    // Only touched by the recording thread until it was joined
+    private var encodedFrames = 0L
+    private var track = -1
+    private var isMuxerStarted = false
+
+    /** Sets up the microphone, encoder and muxer and starts recording. Throws if any of them fails. */
+    @SuppressLint("MissingPermission")
+    fun start() {
+        val minBufferSize = AudioRecord.getMinBufferSize(sampleRate, CHANNEL_CONFIG, AudioFormat.ENCODING_PCM_16BIT)
+        require(minBufferSize > 0) { "Unsupported sample rate $sampleRate" }
+        val frameBytes = framesPerLevel * BYTES_PER_FRAME
+        val record = AudioRecord(
+            MediaRecorder.AudioSource.MIC,
+            sampleRate,
+            CHANNEL_CONFIG,
+            AudioFormat.ENCODING_PCM_16BIT,
+            maxOf(minBufferSize, frameBytes * BUFFERED_FRAMES)
+        )
+        var encoder: MediaCodec? = null
+        var muxer: MediaMuxer? = null
+        try {
+            check(record.state == AudioRecord.STATE_INITIALIZED) { "AudioRecord failed to initialize" }
+            val format = MediaFormat.createAudioFormat(MediaFormat.MIMETYPE_AUDIO_AAC, sampleRate, 1).apply {
+                setInteger(MediaFormat.KEY_AAC_PROFILE, MediaCodecInfo.CodecProfileLevel.AACObjectLC)
+                setInteger(MediaFormat.KEY_BIT_RATE, bitRate)
+                setInteger(MediaFormat.KEY_MAX_INPUT_SIZE, frameBytes)
+            }
+            encoder = MediaCodec.createEncoderByType(MediaFormat.MIMETYPE_AUDIO_AAC).apply {
+                configure(format, null, null, MediaCodec.CONFIGURE_FLAG_ENCODE)
+                start()
+            }
+            muxer = MediaMuxer(path, MediaMuxer.OutputFormat.MUXER_OUTPUT_MPEG_4)
+            record.startRecording()
+        } catch (e: Exception) {
+            encoder?.release()
+            muxer?.release()
+            record.release()
+            throw e
+        }
+
+        isRunning = true
+        val startedEncoder = encoder
+        val startedMuxer = muxer
+        thread = Thread({ run(record, startedEncoder, startedMuxer) }, "AudioWaveformRecorder").apply { start() }
+    }
+
+    /** Stops recording, finishes the file and returns its duration in milliseconds, or -1 if it is empty. */
+    fun stop(): Long {
+        isRunning = false
+        thread?.join()
+        thread = null
+        return if (isMuxerStarted && encodedFrames > 0) encodedFrames * 1000 / sampleRate else -1
+    }
+
+    private fun run(record: AudioRecord, encoder: MediaCodec, muxer: MediaMuxer) {
+        Process.setThreadPriority(Process.THREAD_PRIORITY_URGENT_AUDIO)
+        val frameBytes = framesPerLevel * BYTES_PER_FRAME
+        val pcm = ByteBuffer.allocateDirect(frameBytes).order(ByteOrder.nativeOrder())
+        val reducer = WaveformReducer(1, framesPerLevel.toLong())
+        // The length is not known yet, so the pyramid keeps the finest base level
+        val pyramid = peakCache?.let { PeakPyramid(1, 0) }
+        val rms = FloatArray(1)
+        val peak = FloatArray(1)
+        val batch = FloatArray(maxOf(1, (batchIntervalMs * LEVELS_PER_SECOND / 1000).toInt()))
+        var batched = 0
+        val info = MediaCodec.BufferInfo()
+
+        try {
+            while (isRunning) {
+                val read = record.read(pcm, frameBytes)
+                if (read == AudioRecord.ERROR_INVALID_OPERATION || read == AudioRecord.ERROR_DEAD_OBJECT) {
+                    Log.e(Constants.LOG_TAG, "AudioRecord read failed: $read")
+                    break
+                }
+                if (read <= 0 || isPaused) continue
+
+                if (reducer.processDirect(pcm, 0, read, PCM_ENCODING_BIT, rms, peak, 1) > 0) {
+                    val level = toLevel(peak[0])
+                    lastLevel = level
+                    batch[batched++] = level
+                    if (batched == batch.size) {
+                        onLevels(batch.copyOf())
+                        batched = 0
+                    }
+                }
+                pyramid?.processDirect(pcm, 0, read, PCM_ENCODING_BIT)
+                encode(encoder, muxer, info, pcm, read)
+            }
+            if (batched > 0) onLevels(batch.copyOf(batched))
+            finishEncoding(encoder, muxer, info)
+        } catch (e: Exception) {
+            Log.e(Constants.LOG_TAG, "PCM recording failed", e)
+        } finally {
+            reducer.release()
+            try {
+                record.stop()
+            } catch (e: IllegalStateException) {
+                Log.e(Constants.LOG_TAG, "Failed to stop AudioRecord", e)
+            }
+            record.release()
+            encoder.release()
+            try {
+                if (isMuxerStarted) muxer.stop()
+            } catch (e: IllegalStateException) {
+                Log.e(Constants.LOG_TAG, "Failed to finish the recording file", e)
+                isMuxerStarted = false
+            }
+            muxer.release()
+            // The cache is keyed by the file's size and modification time, so only the finished file
+            if (pyramid != null && isMuxerStarted && encodedFrames > 0) peakCache?.store(path, pyramid)
+            pyramid?.release()
+        }
+    }
+
+    private fun encode(encoder: MediaCodec, muxer: MediaMuxer, info: MediaCodec.BufferInfo, pcm: ByteBuffer, size: Int) {
+        var index = encoder.dequeueInputBuffer(INPUT_TIMEOUT_US)
+        if (index < 0) {
+            // The encoder is behind, hand it its output and wait once more before dropping the frame
+            drainEncoder(encoder, muxer, info, false)
+            index = encoder.dequeueInputBuffer(INPUT_TIMEOUT_US)
+        }
+        if (index >= 0) {
+            val input = encoder.getInputBuffer(index)
+            if (input != null) {
+                input.clear()
+                pcm.position(0).limit(size)
+                input.put(pcm)
+                pcm.clear()
+                encoder.queueInputBuffer(index, 0, size, presentationTimeUs(), 0)
+                encodedFrames += size / BYTES_PER_FRAME
+            }
+        }
+        drainEncoder(encoder, muxer, info, false)
+    }
+
+    private fun finishEncoding(encoder: MediaCodec, muxer: MediaMuxer, info: MediaCodec.BufferInfo) {
+        val index = encoder.dequeueInputBuffer(EOS_TIMEOUT_US)
+        if (index >= 0) {
+            encoder.queueInputBuffer(index, 0, 0, presentationTimeUs(), MediaCodec.BUFFER_FLAG_END_OF_STREAM)
+            drainEncoder(encoder, muxer, info, true)
+        }
+        encoder.stop()
+    }
+
+    /** Writes the encoder's pending output to the muxer; with [endOfStream] until the last buffer. */
+    private fun drainEncoder(encoder: MediaCodec, muxer: MediaMuxer, info: MediaCodec.BufferInfo, endOfStream: Boolean) {
+        var idleTries = 0
+        while (true) {
+            val index = encoder.dequeueOutputBuffer(info, if (endOfStream) EOS_TIMEOUT_US else 0)
+            when {
+                index == MediaCodec.INFO_TRY_AGAIN_LATER -> {
+                    if (!endOfStream || ++idleTries >= MAX_EOS_TRIES) return
+                }
+                index == MediaCodec.INFO_OUTPUT_FORMAT_CHANGED -> {
+                    if (!isMuxerStarted) {
+                        track = muxer.addTrack(encoder.outputFormat)
+                        muxer.start()
+                        isMuxerStarted = true
+                    }
+                }
+                index >= 0 -> {
+                    val output = encoder.getOutputBuffer(index)
+                    if (info.flags and MediaCodec.BUFFER_FLAG_CODEC_CONFIG != 0) info.size = 0
+                    if (output != null && info.size > 0 && isMuxerStarted) {
+                        output.position(info.offset).limit(info.offset + info.size)
+                        muxer.writeSampleData(track, output, info)
+                    }
+                    encoder.releaseOutputBuffer(index, false)
+                    if (info.flags and MediaCodec.BUFFER_FLAG_END_OF_STREAM != 0) return
+                }
+            }
+        }
+    }
+
+    // Paused time is not encoded, so timestamps follow the encoded frames rather than the clock
+    private fun presentationTimeUs() = encodedFrames * 1_000_000L / sampleRate
+
+    companion object {
+        private const val LEVELS_PER_SECOND = 100
+        private const val CHANNEL_CONFIG = AudioFormat.CHANNEL_IN_MONO
+        private const val PCM_ENCODING_BIT = 16
+        private const val BYTES_PER_FRAME = 2
+        // AudioRecord buffer, in 10 ms frames, to ride out scheduling hiccups of the recording thread
+        private const val BUFFERED_FRAMES = 8
+        private const val INPUT_TIMEOUT_US = 5_000L
+        private const val EOS_TIMEOUT_US = 10_000L
+        private const val MAX_EOS_TRIES = 50
+
+        /** Same scale as the MediaRecorder path: dB of the 16-bit peak amplitude, divided by 1000 */
+        private fun toLevel(peak: Float): Float {
+            val amplitude = peak * Short.MAX_VALUE
+            return if (amplitude < 1f) 0f else (20 * log10(amplitude) / 1000)
+        }
+    }
+}
@@ -0,0 +1,53 @@
+package com.audiowaveform
+
+/**
+ * On-disk cache of raw waveform peaks (cpp/PeakCache.h), keyed by path, size and mtime of the
+ * source file. A hit is served without creating a MediaExtractor or decoder.
+ */
+class PeakCache(private val directory: String) {
+
+    /** Returns the raw RMS and peak values of [path] at [bucketCount] buckets, or null on a miss. */
+    fun load(path: String, bucketCount: Int): Array<FloatArray>? {
+        return try {
+            nativeLoad(directory, path, bucketCount)
+        } catch (e: Exception) {
+            null
+        }
+    }
+
+    fun store(path: String, rms: FloatArray, peaks: FloatArray): Boolean {
+        return try {
+            nativeStore(directory, path, rms, peaks)
+        } catch (e: Exception) {
+            false
+        }
+    }
+
+    /** Adds every level of [pyramid] to the cache file of [path]. */
+    fun store(path: String, pyramid: PeakPyramid): Boolean {
+        return try {
+            pyramid.storeInCache(directory, path)
+        } catch (e: Exception) {
+            false
+        }
+    }
+
+    /** Adds [rms] and [peaks] and, if given, every level of [pyramid] with a single write. */
+    fun store(path: String, rms: FloatArray, peaks: FloatArray, pyramid: PeakPyramid?): Boolean {
+        if (pyramid == null) return store(path, rms, peaks)
+        return try {
+            pyramid.storeInCache(directory, path, rms, peaks)
+        } catch (e: Exception) {
+            false
+        }
+    }
+
+    private external fun nativeLoad(directory: String, path: String, bucketCount: Int): Array<FloatArray>?
+    private external fun nativeStore(directory: String, path: String, rms: FloatArray, peaks: FloatArray): Boolean
+
+    companion object {
+        init {
+            System.loadLibrary("audiowaveform")
+        }
+    }
+}
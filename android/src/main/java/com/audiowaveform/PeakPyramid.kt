@@ -0,0 +1,54 @@
+package com.audiowaveform
+
+import java.nio.ByteBuffer
+
+/**
+ * Kotlin handle to the shared peak pyramid (cpp/PeakPyramid.h). Fed the same decoded PCM as the
+ * [WaveformReducer], it keeps power-of-two resolutions of the whole file so other sample counts
+ * can later be served from the [PeakCache] without decoding again.
+ */
+class PeakPyramid(channels: Int, totalFrames: Long) {
+    private var handle: Long = nativeCreate(channels, totalFrames)
+
+    @Synchronized
+    fun process(data: ByteArray, size: Int, pcmEncodingBit: Int) {
+        if (handle == 0L) return
+        nativeProcess(handle, data, size, pcmEncodingBit)
+    }
+
+    /** Same as [process] but reads [size] bytes starting at [offset] of a direct [buffer] in place. */
+    @Synchronized
+    fun processDirect(buffer: ByteBuffer, offset: Int, size: Int, pcmEncodingBit: Int) {
+        if (handle == 0L) return
+        nativeProcessDirect(handle, buffer, offset, size, pcmEncodingBit)
+    }
+
+    /**
+     * Finishes the pyramid and adds all of its levels to the cache file of [path] in [directory],
+     * together with the [rms] and [peaks] of a direct reduction if given, in one write.
+     */
+    @Synchronized
+    fun storeInCache(directory: String, path: String, rms: FloatArray? = null, peaks: FloatArray? = null): Boolean {
+        if (handle == 0L) return false
+        return nativeStoreInCache(handle, directory, path, rms, peaks)
+    }
+
+    @Synchronized
+    fun release() {
+        if (handle == 0L) return
+        nativeDestroy(handle)
+        handle = 0L
+    }
+
+    private external fun nativeCreate(channels: Int, totalFrames: Long): Long
+    private external fun nativeDestroy(handle: Long)
+    private external fun nativeProcess(handle: Long, data: ByteArray, size: Int, encodingBit: Int)
+    private external fun nativeProcessDirect(handle: Long, buffer: ByteBuffer, offset: Int, size: Int, encodingBit: Int)
+    private external fun nativeStoreInCache(handle: Long, directory: String, path: String, rms: FloatArray?, peaks: FloatArray?): Boolean
+
+    companion object {
+        init {
+            System.loadLibrary("audiowaveform")
+        }
+    }
+}
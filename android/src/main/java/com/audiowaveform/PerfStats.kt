@@ -0,0 +1,85 @@
+package com.audiowaveform
+
+import android.os.Build
+import android.os.Trace
+import com.facebook.react.bridge.Arguments
+import com.facebook.react.bridge.WritableMap
+
+/**
+ * Opt-in counters of extraction and playback per player key, read with getPerfStats. Nothing is
+ * counted until [isEnabled] is set. The phases are traced as `AudioWaveform:` sections whether
+ * counting is on or not, so they show up in Perfetto and systrace captures.
+ */
+object PerfStats {
+    const val TRACE_PREFIX = "AudioWaveform:"
+
+    @Volatile var isEnabled = false
+
+    class Entry {
+        var extractions = 0
+        // Wall time from opening the file until the extraction stopped, reduction included
+        var decodeMs = 0.0
+        var reductionMs = 0.0
+        // Compressed bytes handed to the decoder
+        var bytesRead = 0L
+        var cacheHits = 0
+        var cacheMisses = 0
+        // Time spent pending in the ExtractionScheduler
+        var queueWaitMs = 0.0
+        var eventsEmitted = 0
+        // From preparePlayer until the player was first heard, of the latest prepare; -1 before
+        var prepareToFirstAudioMs = -1.0
+    }
+
+    private val entries = HashMap<String, Entry>()
+
+    /** Applies [update] to the entry of [key], if counting is on. */
+    fun record(key: String, update: Entry.() -> Unit) {
+        if (!isEnabled) return
+        synchronized(entries) { entries.getOrPut(key) { Entry() }.update() }
+    }
+
+    /** All entries keyed by player key, cleared afterwards with [reset]. */
+    fun snapshot(reset: Boolean): WritableMap {
+        val result = Arguments.createMap()
+        synchronized(entries) {
+            for ((key, entry) in entries) {
+                result.putMap(key, Arguments.createMap().apply {
+                    putInt("extractions", entry.extractions)
+                    putDouble("decodeMs", entry.decodeMs)
+                    putDouble("reductionMs", entry.reductionMs)
+                    putDouble("bytesRead", entry.bytesRead.toDouble())
+                    putInt("cacheHits", entry.cacheHits)
+                    putInt("cacheMisses", entry.cacheMisses)
+                    putDouble("queueWaitMs", entry.queueWaitMs)
+                    putInt("eventsEmitted", entry.eventsEmitted)
+                    putDouble("prepareToFirstAudioMs", entry.prepareToFirstAudioMs)
+                })
+            }
+            if (reset) entries.clear()
+        }
+        return result
+    }
+
+    /** Milliseconds since [startNanos], a System.nanoTime() reading */
+    fun elapsedMs(startNanos: Long) = (System.nanoTime() - startNanos) / 1e6
+
+    /** Runs [block] inside the trace section [name]. */
+    inline fun <T> trace(name: String, block: () -> T): T {
+        Trace.beginSection(TRACE_PREFIX + name)
+        try {
+            return block()
+        } finally {
+            Trace.endSection()
+        }
+    }
+
+    /** Starts the trace section [name] that [endAsync] ends later, on any thread. Android 10+. */
+    fun beginAsync(name: String, cookie: Int) {
+        if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.Q) Trace.beginAsyncSection(TRACE_PREFIX + name, cookie)
+    }
+
+    fun endAsync(name: String, cookie: Int) {
+        if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.Q) Trace.endAsyncSection(TRACE_PREFIX + name, cookie)
+    }
+}
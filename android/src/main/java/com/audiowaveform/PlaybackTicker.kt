@@ -0,0 +1,97 @@
+package com.audiowaveform
+
+import android.os.Handler
+import android.os.Looper
+import com.facebook.react.bridge.Arguments
+import com.facebook.react.bridge.ReactApplicationContext
+import com.facebook.react.bridge.WritableMap
+import com.facebook.react.modules.core.DeviceEventManagerModule
+
+/**
+ * One position ticker for all playing [AudioPlayer]s. Each tick snapshots the position of every
+ * registered player and sends them in a single onCurrentDurations event, instead of a timer and
+ * a bridge call per player. Runs on the players' application looper, which ExoPlayer requires
+ * for reading positions; all methods must be called there too.
+ *
+ * Every entry carries the wall clock time it was read at, the playback speed and whether the
+ * player is playing, so listeners can extrapolate the position between ticks.
+ */
+class PlaybackTicker(private val context: ReactApplicationContext) {
+    private val players = LinkedHashMap<String, AudioPlayer>()
+    // The update interval each registered player asked for
+    private val intervals = HashMap<String, Long>()
+    private var handler: Handler? = null
+    private var intervalMs = UpdateFrequency.Low.value
+    private var isTicking = false
+
+    private val tick = object : Runnable {
+        override fun run() {
+            emit(players.values)
+            handler?.postDelayed(this, intervalMs)
+        }
+    }
+
+    /** Adds [player] to the ticks, which run at the fastest update frequency of the registered players. */
+    fun register(player: AudioPlayer, looper: Looper, frequency: UpdateFrequency) {
+        players[player.key] = player
+        intervals[player.key] = frequency.value
+        if (handler?.looper != looper) {
+            handler?.removeCallbacks(tick)
+            handler = Handler(looper)
+            isTicking = false
+        }
+        schedule()
+    }
+
+    fun unregister(key: String) {
+        if (players.remove(key) == null) return
+        intervals.remove(key)
+        schedule()
+    }
+
+    /**
+     * Ticks at the shortest interval of the registered players, so a fast player leaving slows the
+     * ticks down again, and stops without players. Re-arms only when the interval changes.
+     */
+    private fun schedule() {
+        val interval = intervals.values.minOrNull()
+        if (interval == null) {
+            handler?.removeCallbacks(tick)
+            isTicking = false
+            return
+        }
+        if (isTicking && interval == intervalMs) return
+        intervalMs = interval
+        isTicking = true
+        handler?.removeCallbacks(tick)
+        handler?.postDelayed(tick, intervalMs)
+    }
+
+    /** Sends the current position of [targets] at once, e.g. on start, pause or stop. */
+    fun emit(targets: Collection<AudioPlayer>) {
+        val durations = Arguments.createArray()
+        for (player in targets) {
+            if (!player.isComponentMounted) continue
+            val position = player.currentPosition() ?: continue
+            val entry: WritableMap = Arguments.createMap()
+            entry.putString(Constants.currentDuration, position.toString())
+            entry.putString(Constants.playerKey, player.key)
+            entry.putDouble(Constants.timestamp, System.currentTimeMillis().toDouble())
+            entry.putDouble(Constants.speed, player.playbackSpeed().toDouble())
+            entry.putBoolean(Constants.isPlaying, player.isPlaying())
+            durations.pushMap(entry)
+        }
+        if (durations.size() == 0) return
+        val args: WritableMap = Arguments.createMap()
+        args.putArray(Constants.durations, durations)
+        context.getJSModule(DeviceEventManagerModule.RCTDeviceEventEmitter::class.java)
+            ?.emit(Constants.onCurrentDurations, args)
+    }
+
+    fun release() {
+        handler?.removeCallbacks(tick)
+        isTicking = false
+        players.clear()
+        intervals.clear()
+    }
+}
@@ -0,0 +1,76 @@
+package com.audiowaveform
+
+import android.content.Context
+import android.net.Uri
+import android.os.Handler
+import androidx.media3.common.MediaItem
+import androidx.media3.common.PlaybackParameters
+import androidx.media3.exoplayer.ExoPlayer
+
+/**
+ * Keeps up to [maxIdle] ExoPlayers alive between plays. A stopped player is parked still prepared
+ * for its path, so playing the same file again skips the cold prepare (extractor probing, decoder
+ * setup, first buffering), and [prefetch] runs that prepare ahead of a tap. Idle players are
+ * evicted least recently used first, and a full pool hands its eldest player to a new path
+ * instead of building another one. Must be used from the thread the players are built on, the
+ * module's native modules thread.
+ */
+class PlayerPool(private val context: Context, private val maxIdle: Int = MAX_IDLE_PLAYERS) {
+    // Access ordered, so the first entry is the least recently used
+    private val idle = LinkedHashMap<String, ExoPlayer>(maxIdle, 0.75f, true)
+
+    /**
+     * A player for [path]: the parked one if it was prefetched or played before, otherwise a
+     * reused or new player that is preparing. The caller owns it until [recycle].
+     */
+    fun acquire(path: String): ExoPlayer {
+        idle.remove(path)?.let { return it }
+        val player = takeEldestIfFull() ?: ExoPlayer.Builder(context).build()
+        player.setMediaItem(MediaItem.fromUri(Uri.parse(path)))
+        player.prepare()
+        return player
+    }
+
+    /** Parks [player] at the start of [path], paused and still prepared. */
+    fun recycle(path: String, player: ExoPlayer) {
+        player.playWhenReady = false
+        player.seekTo(0)
+        player.volume = 1f
+        player.playbackParameters = PlaybackParameters.DEFAULT
+        idle.remove(path)?.release()
+        idle[path] = player
+        while (idle.size > maxIdle) {
+            val eldest = idle.entries.first()
+            idle.remove(eldest.key)
+            eldest.value.release()
+        }
+    }
+
+    /** Prepares a player for [path] in the background. Returns false if one was already parked. */
+    fun prefetch(path: String): Boolean {
+        if (idle[path] != null) return false
+        recycle(path, acquire(path))
+        return true
+    }
+
+    /** Releases all parked players, from any thread. */
+    fun clear() {
+        val players = idle.values.toList()
+        idle.clear()
+        players.forEach { player -> Handler(player.applicationLooper).post { player.release() } }
+    }
+
+    private fun takeEldestIfFull(): ExoPlayer? {
+        if (idle.size < maxIdle) return null
+        val eldest = idle.entries.first()
+        idle.remove(eldest.key)
+        eldest.value.stop()
+        eldest.value.clearMediaItems()
+        return eldest.value
+    }
+
+    companion object {
+        // Each parked player holds a decoder and its buffers, voice note screens rarely need more
+        private const val MAX_IDLE_PLAYERS = 3
+    }
+}
@@ -8,6 +8,8 @@ object Constants {
     const val LOG_TAG = "AudioWaveforms"
     const val fileNameFormat = "dd-MM-yy-hh-mm-ss"
     const val currentDuration = "currentDuration"
+    const val durations = "durations"
+    const val onCurrentDurations = "onCurrentDurations"
 
 
     /** encoder */
@@ -36,14 +38,42 @@ object Constants {
     const val finishMode = "finishMode"
     const val finishType = "finishType"
     const val noOfSamples = "noOfSamples"
+    const val withPeaks = "withPeaks"
+    const val useCache = "useCache"
+    const val priority = "priority"
+    const val progressMode = "progressMode"
+    const val progressInterval = "progressInterval"
+    const val fromIndex = "fromIndex"
+    const val binary = "binary"
+    const val downloadPath = "downloadPath"
+    const val bufferId = "bufferId"
+    const val maxConcurrentExtractions = "maxConcurrentExtractions"
+    const val waveformCacheDirectory = "waveforms"
     const val onCurrentRecordingWaveformData = "onCurrentRecordingWaveformData"
     const val onCurrentExtractedWaveformData = "onCurrentExtractedWaveformData"
     const val waveformData = "waveformData"
+    const val duration = "duration"
+    const val playerError = "playerError"
     const val updateFrequency = "updateFrequency"
     const val currentDecibel = "currentDecibel"
     const val bitRate = "bitRate"
     const val sampleRate = "sampleRate"
+    const val engine = "engine"
+    const val pcmEngine = "pcm"
+    const val levels = "levels"
+    const val waveformSamples = "waveformSamples"
+    const val enabled = "enabled"
+    const val reset = "reset"
     const val speed = "speed"
+    const val timestamp = "timestamp"
+    const val isPlaying = "isPlaying"
+    const val interpolatePosition = "interpolatePosition"
+    const val channelMode = "channelMode"
+    const val preview = "preview"
+    const val scale = "scale"
+    const val threshold = "threshold"
+    const val items = "items"
+    const val lengths = "lengths"
 }
 
 enum class FinishMode(val value:Int) {
@@ -52,8 +82,45 @@ enum class FinishMode(val value:Int) {
     Stop(2)
 }
 
+enum class ProgressMode {
+    // All values extracted so far, at most once per progress interval
+    Full,
+    // Only the values added since the previous event, at most once per progress interval
+    Delta,
+    // No progress events, for batches and callers that only await the result
+    None;
+
+    companion object {
+        fun from(value: String?) = when (value) {
+            "delta" -> Delta
+            "none" -> None
+            else -> Full
+        }
+    }
+}
+
+/** Matches audiowaveform::ChannelMode of the native kernel */
+enum class ChannelMode(val value: Int) {
+    // One value per bucket over all channels
+    Mixdown(0),
+    // One value per bucket, of the loudest channel
+    Max(1),
+    // All buckets of the first channel, then those of the next one
+    PerChannel(2);
+
+    companion object {
+        fun from(value: String?) = when (value) {
+            "max" -> Max
+            "perChannel" -> PerChannel
+            else -> Mixdown
+        }
+    }
+}
+
 enum class UpdateFrequency(val value:Long) {
     High(50),
     Medium(100),
     Low(200),
+    // Players whose position is extrapolated between ticks only need them to correct drift
+    Interpolated(1000),
 }
\ No newline at end of file
@@ -2,18 +2,21 @@ package com.audiowaveform
 
 import android.media.AudioFormat
 import android.media.MediaCodec
+import android.media.MediaDataSource
 import android.media.MediaExtractor
 import android.media.MediaFormat
 import android.net.Uri
 import android.os.Build
+import android.os.Handler
+import android.os.HandlerThread
+import android.os.SystemClock
 import com.facebook.react.bridge.Arguments
 import com.facebook.react.bridge.ReactApplicationContext
 import com.facebook.react.bridge.ReactContextBaseJavaModule
+import com.facebook.react.bridge.WritableArray
 import com.facebook.react.bridge.WritableMap
 import com.facebook.react.modules.core.DeviceEventManagerModule
 import java.nio.ByteBuffer
-import kotlin.math.pow
-import kotlin.math.sqrt
 import java.io.File
 
 class WaveformExtractor(
@@ -22,21 +25,53 @@ class WaveformExtractor(
     private val expectedPoints: Int,
     private val key: String,
     private val extractorCallBack: ExtractorCallBack,
+    // Also collect the per-bucket peak next to the RMS value
+    val withPeaks: Boolean = false,
+    // Also build the multi-resolution pyramid of the whole file for the peak cache
+    private val buildPyramid: Boolean = false,
+    private val progressMode: ProgressMode = ProgressMode.Full,
+    // Minimum time between two progress events
+    private val progressIntervalMs: Long = DEFAULT_PROGRESS_INTERVAL_MS,
+    // Send progress slices as WaveformJsi buffer ids instead of bridge arrays
+    private val binary: Boolean = false,
+    // Where an HTTP(S) path is saved once it was read, see HttpRangeDataSource
+    private val downloadPath: String? = null,
+    // How the channels are combined, progress events always carry one value per bucket
+    private val channelMode: ChannelMode = ChannelMode.Mixdown,
+    // Send a WaveformPreview of a long local file before decoding it in full
+    private val preview: Boolean = false,
+    // Values below it are left out of normalizationMax
+    private val threshold: Float = DEFAULT_NORMALIZATION_THRESHOLD,
 ): ReactContextBaseJavaModule(context) {
     private var decoder: MediaCodec? = null
     private var extractor: MediaExtractor? = null
+    private var remoteSource: MediaDataSource? = null
+    private var remoteThread: HandlerThread? = null
     private var duration = 0L
     private var progress = 0F
-    private var currentProgress = 0F
 
     @Volatile
     private var inProgress = false
+    // Serialises output buffer access with stop() so a buffer is never read after the codec is released
+    private val codecLock = Any()
     private var inputEof = false
     private var sampleRate = 0
     private var channels = 1
     private var pcmEncodingBit = 16
     private var totalSamples = 0L
     private var perSamplePoints = 0L
+    private var reducer: WaveformReducer? = null
+    private var pyramid: PeakPyramid? = null
+    private var pcmChunk = ByteArray(0)
+    private var bucketChunk = FloatArray(0)
+    private var peakChunk = FloatArray(0)
+    private var emittedPoints = 0
+    private var lastEmitTime = 0L
+    // For PerfStats, reported when the extraction stops
+    private var decodeStartNanos = 0L
+    private var reductionNanos = 0L
+    private var bytesRead = 0L
+    private var eventsEmitted = 0
 
     override fun getName(): String {
         return "WaveformExtractor"
@@ -45,8 +80,14 @@ class WaveformExtractor(
     private fun getFormat(path: String): MediaFormat? {
         val mediaExtractor = MediaExtractor()
         this.extractor = mediaExtractor
-        val uri = Uri.parse(path)
-        mediaExtractor.setDataSource(this.reactApplicationContext, uri, null)
+        if (HttpRangeDataSource.isRemote(path) && Build.VERSION.SDK_INT >= Build.VERSION_CODES.M) {
+            val source = HttpRangeDataSource(path, downloadPath, reactApplicationContext.cacheDir)
+            remoteSource = source
+            mediaExtractor.setDataSource(source)
+        } else {
+            val uri = Uri.parse(path)
+            mediaExtractor.setDataSource(this.reactApplicationContext, uri, null)
+        }
         val trackCount = mediaExtractor.trackCount
         repeat(trackCount) {
             val format = mediaExtractor.getTrackFormat(it)
@@ -60,24 +101,51 @@ class WaveformExtractor(
         return null
     }
 
-    fun startDecode() {
-        try {
-            if (!File(path).exists()) {
-                extractorCallBack.onReject("File Error", "File does not exist at the given path.")
+    fun startDecode(): Unit = PerfStats.trace("startDecode") {
+        if (HttpRangeDataSource.isRemote(path)) {
+            if (Build.VERSION.SDK_INT < Build.VERSION_CODES.M) {
+                extractorCallBack.onReject("File Error", "Remote files need Android 6.0 or later.")
                 return
             }
+            // Reads block on the network, so they get a thread of their own instead of holding
+            // up the scheduler thread that the local extractions' decoders call back on
+            val thread = HandlerThread("AudioWaveformRemoteExtraction").apply { start() }
+            remoteThread = thread
+            val handler = Handler(thread.looper)
+            handler.post { decode(handler) }
+            return
+        }
+        if (!File(path).exists()) {
+            extractorCallBack.onReject("File Error", "File does not exist at the given path.")
+            return
+        }
+        decode(null)
+    }
 
+    /**
+     * Decodes on the decoders' callback thread, or the thread of [callbackHandler]. Values are
+     * extracted and sent as progress while the file is still being read, which for a remote file
+     * means while it downloads.
+     */
+    private fun decode(callbackHandler: Handler?) {
+        decodeStartNanos = System.nanoTime()
+        try {
+            // Seeking a remote file would open a range request per window
+            if (preview && !HttpRangeDataSource.isRemote(path)) {
+                WaveformPreview.extract(reactApplicationContext, path, expectedPoints)?.let { emitPreview(it) }
+            }
             val format = getFormat(path) ?: error("No audio format found")
             val mime = format.getString(MediaFormat.KEY_MIME) ?: error("No MIME type found")
             decoder = MediaCodec.createDecoderByType(mime).also {
                 it.configure(format, null, null, 0)
-                it.setCallback(object : MediaCodec.Callback() {
+                val callback = object : MediaCodec.Callback() {
                     override fun onInputBufferAvailable(codec: MediaCodec, index: Int) {
                         if (inputEof || !inProgress) return
                         val extractor = extractor ?: return
                         codec.getInputBuffer(index)?.let { buf ->
                             val size = extractor.readSampleData(buf, 0)
                             if (size > 0) {
+                                bytesRead += size
                                 codec.queueInputBuffer(index, 0, size, extractor.sampleTime, 0)
                                 extractor.advance()
                             } else {
@@ -97,25 +165,18 @@ class WaveformExtractor(
                         if(!inProgress) return
                         sampleRate = format.getInteger(MediaFormat.KEY_SAMPLE_RATE)
                         channels = format.getInteger(MediaFormat.KEY_CHANNEL_COUNT)
-                        pcmEncodingBit = if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.N) {
-                            if (format.containsKey(MediaFormat.KEY_PCM_ENCODING)) {
-                                when (format.getInteger(MediaFormat.KEY_PCM_ENCODING)) {
-                                    AudioFormat.ENCODING_PCM_16BIT -> 16
-                                    AudioFormat.ENCODING_PCM_8BIT -> 8
-                                    AudioFormat.ENCODING_PCM_FLOAT -> 32
-                                    else -> 16
-                                }
-                            } else {
-                                16
-                            }
-                        } else {
-                            16
-                        }
+                        pcmEncodingBit = format.pcmEncodingBit()
                         totalSamples = sampleRate.toLong() * duration
                         perSamplePoints = (totalSamples / expectedPoints)
+                        reducer?.release()
+                        reducer = WaveformReducer(channels, maxOf(1L, perSamplePoints), channelMode)
+                        pyramid?.release()
+                        pyramid = if (buildPyramid) PeakPyramid(channels, totalSamples) else null
                     }
 
                     override fun onError(codec: MediaCodec, e: MediaCodec.CodecException) {
+                        // Later callbacks of the failed codec are ignored once stopped
+                        stop()
                         extractorCallBack.onReject(
                             Constants.LOG_TAG + " " + e.message,
                             "An error is thrown while decoding the audio file"
@@ -127,40 +188,47 @@ class WaveformExtractor(
                         index: Int,
                         info: MediaCodec.BufferInfo
                     ) {
-                        if (inProgress && info.size > 0) {
-                            codec.getOutputBuffer(index)?.let { buf ->
-                                val size = info.size
-                                buf.position(info.offset)
-                                when (pcmEncodingBit) {
-                                    8 -> {
-                                        handle8bit(size, buf)
-                                    }
-                                    16 -> {
-                                        handle16bit(size, buf)
-                                    }
-                                    32 -> {
-                                        handle32bit(size, buf)
-                                    }
+                        synchronized(codecLock) {
+                            if (!inProgress) return
+                            try {
+                                val reduceStart = if (PerfStats.isEnabled) System.nanoTime() else 0L
+                                val isComplete = info.size > 0 && codec.getOutputBuffer(index)?.let { buf ->
+                                    reduce(buf, info.offset, info.size)
+                                } == true
+                                if (reduceStart != 0L) reductionNanos += System.nanoTime() - reduceStart
+                                // Hand the buffer back as soon as it is reduced so the codec output queue never stalls
+                                codec.releaseOutputBuffer(index, false)
+
+                                if (isComplete) {
+                                    // Discard redundant values and release resources
+                                    stop()
+                                } else if (info.isEof()) {
+                                    emitPending()
+                                    stop()
+                                    extractorCallBack.onResolve(resultData, if (withPeaks) resultPeaks else null)
                                 }
-                                // Releasing only if not stopped else we are getting IllegalStateException inaccessible buffer
-                                if(inProgress) codec.releaseOutputBuffer(index, false)
+                            } catch (e: Exception) {
+                                stop()
+                                extractorCallBack.onReject("RMS ERROR", e.message)
                             }
                         }
-
-                        if (info.isEof()) {
-                            stop()
-                            val tempArrayForCommunication : MutableList<MutableList<Float>> = mutableListOf()
-                            tempArrayForCommunication.add(sampleData)
-                            extractorCallBack.onResolve(tempArrayForCommunication)
-                        }
                     }
-                })
+                }
+                if (callbackHandler != null && Build.VERSION.SDK_INT >= Build.VERSION_CODES.M) {
+                    it.setCallback(callback, callbackHandler)
+                } else {
+                    it.setCallback(callback)
+                }
                 inProgress = true
+                PerfStats.beginAsync("extractWaveform", System.identityHashCode(this))
                 it.start()
             }
 
         } catch (e: Exception) {
             stop()
+            // stop() only cleans up a started decode
+            remoteSource?.close()
+            remoteThread?.quitSafely()
             extractorCallBack.onReject(
                 e.message , "An error is thrown before decoding the audio file"
             )
@@ -168,91 +236,163 @@ class WaveformExtractor(
         }
     }
 
-    var sampleData : MutableList<Float> = mutableListOf()
-    private var sampleCount = 0L
-    private var sampleSum = 0.0
+    // Raw RMS and peak of every bucket, written in place; the first extractedPoints are set
+    val sampleData = FloatArray(expectedPoints)
+    val peakData = FloatArray(expectedPoints)
+    private var extractedPoints = 0
+    // Largest result value at or above threshold, tracked while extracting
+    private var maxLevel = Float.NaN
+    // ChannelMode.PerChannel values of more than one channel, expectedPoints per channel
+    private var channelData = FloatArray(0)
+    private var channelPeakData = FloatArray(0)
 
-    private fun rms(value: Float): Boolean {
-        try {
-            if (sampleCount == perSamplePoints) {
-                currentProgress++
-                progress = (currentProgress / expectedPoints)
-
-                val rms = sqrt(sampleSum / perSamplePoints)
-                sampleData.add(rms.toFloat())
-                extractorCallBack.onProgress(progress)
-                sampleCount = 0
-                sampleSum = 0.0
-
-                val argsParams: WritableMap = Arguments.createMap()
-                argsParams.putArray(Constants.waveformData, Arguments.fromList(sampleData))
-                argsParams.putString(Constants.progress, progress.toString())
-                argsParams.putString(Constants.playerKey, key)
-                reactApplicationContext?.getJSModule(DeviceEventManagerModule.RCTDeviceEventEmitter::class.java)?.emit(Constants.onCurrentExtractedWaveformData, argsParams)
-
-                // Discard redundant values and release resources
-                if (progress >= 1.0F) {
-                    stop()
-                    return true
-                }
-            }
+    /**
+     * The RMS values to resolve with. With [ChannelMode.PerChannel] these are the [expectedPoints]
+     * values of the first channel, then those of the next one and so on, so the channel count is
+     * the size divided by [expectedPoints].
+     */
+    val resultData: FloatArray
+        get() = result(sampleData, channelData)
+
+    /** The peaks to resolve with, laid out like [resultData] */
+    val resultPeaks: FloatArray
+        get() = result(peakData, channelPeakData)
+
+    /** The value [resultData] is normalized by, see WaveformReducer.normalizationMax */
+    val normalizationMax: Float
+        get() = if (maxLevel.isNaN()) 1f else maxLevel
+
+    private fun trackLevel(value: Float) {
+        if (value >= threshold && !(value <= maxLevel)) maxLevel = value
+    }
+
+    private fun result(values: FloatArray, channelValues: FloatArray): FloatArray = when {
+        channelValues.isNotEmpty() -> channelValues
+        channelMode == ChannelMode.PerChannel || extractedPoints == values.size -> values
+        // A file that ended early
+        else -> values.copyOf(extractedPoints)
+    }
+
+    /**
+     * Reduces one decoded output buffer in place. Returns true once all expected points are extracted.
+     */
+    private fun reduce(buf: ByteBuffer, offset: Int, size: Int): Boolean {
+        val reducer = reducer ?: return false
+        if (!buf.isDirect) {
+            if (pcmChunk.size < size) pcmChunk = ByteArray(size)
+            buf.position(offset)
+            buf.get(pcmChunk, 0, size)
         }
-        catch (e: Exception) {
-            stop()
-            extractorCallBack.onReject("RMS ERROR" ,e.message)
-            return true;
+        // The pyramid sees every buffer, before onBucket can complete and stop the extraction
+        pyramid?.let {
+            if (buf.isDirect) it.processDirect(buf, offset, size, pcmEncodingBit) else it.process(pcmChunk, size, pcmEncodingBit)
         }
-        sampleCount++
-        sampleSum += value.toDouble().pow(2.0)
-        return false;
+        val remainingPoints = expectedPoints - extractedPoints
+        val capacity = minOf(reducer.maxBucketsFor(size, pcmEncodingBit), remainingPoints)
+        if (capacity <= 0) return false
+        val values = reducer.valuesPerBucket
+        if (bucketChunk.size < capacity * values) bucketChunk = FloatArray(capacity * values)
+        if (peakChunk.size < capacity * values) peakChunk = FloatArray(capacity * values)
+        if (values > 1 && channelData.isEmpty()) {
+            channelData = FloatArray(expectedPoints * values)
+            channelPeakData = FloatArray(expectedPoints * values)
+        }
+        // Peaks are always collected so they can be cached, withPeaks only controls the result
+        val peaks = peakChunk
+
+        val written = if (buf.isDirect) {
+            reducer.processDirect(buf, offset, size, pcmEncodingBit, bucketChunk, peaks, capacity)
+        } else {
+            reducer.process(pcmChunk, size, pcmEncodingBit, bucketChunk, peaks, capacity)
+        }
+        for (i in 0 until written) {
+            val isComplete = if (values > 1) onChannelBucket(i * values, values) else onBucket(bucketChunk[i], peaks[i])
+            if (isComplete) return true
+        }
+        return false
     }
 
-    private fun handle8bit(size: Int, buf: ByteBuffer) {
-        run blockRepeat@ {
-            repeat(size / if (channels == 2) 2 else 1) {
-                val result = buf.get().toInt() / 128f
-                if (channels == 2) {
-                    buf.get()
-                }
-                if (rms(result)) return@blockRepeat
-            }
+    /**
+     * Keeps the [count] per channel values of a bucket from [first] on and reports their mixdown,
+     * the same value [ChannelMode.Mixdown] would have produced, as progress.
+     */
+    private fun onChannelBucket(first: Int, count: Int): Boolean {
+        var sumOfSquares = 0f
+        var peak = 0f
+        for (channel in 0 until count) {
+            val rms = bucketChunk[first + channel]
+            channelData[channel * expectedPoints + extractedPoints] = rms
+            channelPeakData[channel * expectedPoints + extractedPoints] = peakChunk[first + channel]
+            trackLevel(rms)
+            sumOfSquares += rms * rms
+            peak = maxOf(peak, peakChunk[first + channel])
         }
+        return onBucket(kotlin.math.sqrt(sumOfSquares / count), peak)
     }
 
-    private fun handle16bit(size: Int, buf: ByteBuffer) {
-        run blockRepeat@{
-            repeat(size / if (channels == 2) 4 else 2) {
-                val first = buf.get().toInt()
-                val second = buf.get().toInt() shl 8
-                val value = (first or second) / 32767f
-                if (channels == 2) {
-                    buf.get()
-                    buf.get()
-                }
-                if (rms(value)) return@blockRepeat
-            }
+    private fun onBucket(rms: Float, peak: Float): Boolean {
+        if (channelData.isEmpty()) trackLevel(rms)
+        sampleData[extractedPoints] = rms
+        peakData[extractedPoints] = peak
+        extractedPoints++
+        progress = extractedPoints.toFloat() / expectedPoints
+
+        val isComplete = progress >= 1.0F
+        if (isComplete || SystemClock.uptimeMillis() - lastEmitTime >= progressIntervalMs) {
+            emitPending()
         }
+        extractorCallBack.onProgress(progress)
+
+        return isComplete
     }
 
-    private fun handle32bit(size: Int, buf: ByteBuffer) {
-        run blockRepeat@{
-            repeat(size / if (channels == 2) 8 else 4) {
-                val first = buf.get().toLong()
-                val second = buf.get().toLong() shl 8
-                val third = buf.get().toLong() shl 16
-                val forth = buf.get().toLong() shl 24
-                val value = (first or second or third or forth) / "2147483648f".toFloat()
-                if (channels == 2) {
-                    buf.get()
-                    buf.get()
-                    buf.get()
-                    buf.get()
-                }
-                if (rms(value)) return@blockRepeat
-            }
+    /**
+     * Sends the values not sent yet: as a [Constants.fromIndex] slice in [ProgressMode.Delta],
+     * otherwise with all values before them.
+     */
+    private fun emitPending() {
+        if (progressMode == ProgressMode.None || emittedPoints >= extractedPoints) return
+        emitProgress(if (progressMode == ProgressMode.Delta) emittedPoints else 0)
+        emittedPoints = extractedPoints
+        lastEmitTime = SystemClock.uptimeMillis()
+    }
+
+    private fun emitProgress(fromIndex: Int) {
+        val argsParams: WritableMap = Arguments.createMap()
+        if (binary) {
+            argsParams.putDouble(Constants.bufferId, WaveformJsi.putBuffer(sampleData, fromIndex, extractedPoints).toDouble())
+        } else {
+            argsParams.putArray(Constants.waveformData, toWritableArray(sampleData, fromIndex, extractedPoints))
+        }
+        if (progressMode == ProgressMode.Delta) argsParams.putInt(Constants.fromIndex, fromIndex)
+        argsParams.putString(Constants.progress, progress.toString())
+        argsParams.putString(Constants.playerKey, key)
+        reactApplicationContext?.getJSModule(DeviceEventManagerModule.RCTDeviceEventEmitter::class.java)?.emit(Constants.onCurrentExtractedWaveformData, argsParams)
+        eventsEmitted++
+    }
+
+    /** Sends [values] as the [Constants.preview] that the following progress events refine. */
+    private fun emitPreview(values: FloatArray) {
+        val argsParams: WritableMap = Arguments.createMap()
+        if (binary) {
+            argsParams.putDouble(Constants.bufferId, WaveformJsi.putBuffer(values).toDouble())
+        } else {
+            argsParams.putArray(Constants.waveformData, toWritableArray(values, 0, values.size))
         }
+        argsParams.putBoolean(Constants.preview, true)
+        argsParams.putString(Constants.progress, 0f.toString())
+        argsParams.putString(Constants.playerKey, key)
+        reactApplicationContext?.getJSModule(DeviceEventManagerModule.RCTDeviceEventEmitter::class.java)?.emit(Constants.onCurrentExtractedWaveformData, argsParams)
+        eventsEmitted++
     }
 
+    /**
+     * Hands the pyramid decoded so far over to the caller, which stores and releases it. Called
+     * once the requested points are extracted, so a later request for another sample count is a
+     * cache hit.
+     */
+    fun takePyramid(): PeakPyramid? = synchronized(codecLock) { pyramid.also { pyramid = null } }
+
     fun forceStop() {
         stop()
         // When stopped by outside we must notify to resolved the hanging promises
@@ -260,19 +400,57 @@ class WaveformExtractor(
     }
 
     private fun stop() {
-        if (!inProgress) return
-        inProgress = false
-        decoder?.stop()
-        decoder?.release()
-        extractor?.release()
+        synchronized(codecLock) {
+            if (!inProgress) return
+            inProgress = false
+            decoder?.stop()
+            decoder?.release()
+            extractor?.release()
+            // With a download path, closing completes and moves the download in the background
+            remoteSource?.close()
+            reducer?.release()
+            pyramid?.release()
+            remoteThread?.quitSafely()
+            PerfStats.endAsync("extractWaveform", System.identityHashCode(this))
+            PerfStats.record(key) {
+                extractions++
+                decodeMs += PerfStats.elapsedMs(decodeStartNanos)
+                reductionMs += reductionNanos / 1e6
+                bytesRead += this@WaveformExtractor.bytesRead
+                eventsEmitted += this@WaveformExtractor.eventsEmitted
+            }
+        }
     }
 }
 
+const val DEFAULT_PROGRESS_INTERVAL_MS = 16L
+// Normalized waveforms peak at this, with values below the threshold zeroed
+const val DEFAULT_NORMALIZATION_SCALE = 0.12f
+const val DEFAULT_NORMALIZATION_THRESHOLD = 0.01f
+
+/** Bits per sample of a decoder output format, for the reduction kernel */
+fun MediaFormat.pcmEncodingBit(): Int {
+    if (Build.VERSION.SDK_INT < Build.VERSION_CODES.N || !containsKey(MediaFormat.KEY_PCM_ENCODING)) return 16
+    return when (getInteger(MediaFormat.KEY_PCM_ENCODING)) {
+        AudioFormat.ENCODING_PCM_16BIT -> 16
+        AudioFormat.ENCODING_PCM_8BIT -> 8
+        AudioFormat.ENCODING_PCM_FLOAT -> 32
+        else -> 16
+    }
+}
+
+/** Values [from] until [to] as a bridge array, without boxing them into a list first */
+fun toWritableArray(values: FloatArray, from: Int, to: Int): WritableArray {
+    val array = Arguments.createArray()
+    for (index in from until to) array.pushDouble(values[index].toDouble())
+    return array
+}
+
 fun MediaCodec.BufferInfo.isEof() = flags and MediaCodec.BUFFER_FLAG_END_OF_STREAM != 0
 
 interface ExtractorCallBack {
     fun onProgress(value: Float)
     fun onReject(error: String?, message: String?)
-    fun onResolve(value: MutableList<MutableList<Float>>)
+    fun onResolve(rms: FloatArray, peaks: FloatArray?)
     fun onForceStop()
 }
\ No newline at end of file
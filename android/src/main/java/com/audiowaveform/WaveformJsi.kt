@@ -0,0 +1,31 @@
+package com.audiowaveform
+
+/**
+ * Binary transfer of waveform data to JS. Values are put into the shared buffer store
+ * (cpp/WaveformBufferStore.h) and only their id crosses the bridge; JS takes them through
+ * `global.__AudioWaveformJsi.takeBuffer` (cpp/WaveformJsi.h) as an ArrayBuffer over native memory.
+ */
+object WaveformJsi {
+    init {
+        System.loadLibrary("audiowaveform")
+    }
+
+    /** Installs the bindings into the jsi::Runtime at [runtime]. Must be called on the JS thread. */
+    fun install(runtime: Long): Boolean {
+        if (runtime == 0L) return false
+        return nativeInstall(runtime)
+    }
+
+    /**
+     * Stores the values [from] until [to] and returns the id to send to JS. Progress slices may be
+     * dropped when JS falls behind, an [isResult] buffer a promise resolves with only once many
+     * results are left untaken.
+     */
+    fun putBuffer(values: FloatArray, from: Int = 0, to: Int = values.size, isResult: Boolean = false): Long {
+        val start = from.coerceIn(0, values.size)
+        return nativePutBuffer(values, start, to.coerceIn(start, values.size) - start, isResult)
+    }
+
+    private external fun nativeInstall(runtime: Long): Boolean
+    private external fun nativePutBuffer(values: FloatArray, offset: Int, count: Int, isResult: Boolean): Long
+}
@@ -0,0 +1,123 @@
+package com.audiowaveform
+
+import android.content.Context
+import android.media.MediaCodec
+import android.media.MediaExtractor
+import android.media.MediaFormat
+import android.net.Uri
+import android.os.SystemClock
+import android.util.Log
+
+/**
+ * Approximate waveform of a long file from up to [MAX_WINDOWS] short windows spread evenly across
+ * it. Each window seeks to the closest sync sample and decodes about [WINDOW_FRAMES] frames, so
+ * the cost does not grow with the length of the file. The full extraction refines it afterwards.
+ */
+object WaveformPreview {
+    private const val MAX_WINDOWS = 100
+    // About 45 ms at 44.1 kHz, a couple of AAC or MP3 frames
+    private const val WINDOW_FRAMES = 2048L
+    // Shorter files are extracted in full about as fast
+    private const val MIN_DURATION_US = 30_000_000L
+    // A preview that takes longer than this only delays the full pass
+    private const val MAX_PREVIEW_MS = 300L
+    private const val TIMEOUT_US = 10_000L
+    private const val MAX_TRIES_PER_WINDOW = 32
+
+    /**
+     * Decodes the windows synchronously on the calling thread and returns [points] raw RMS
+     * values, each that of the nearest window, or null if the file is short or can not be
+     * previewed in time.
+     */
+    fun extract(context: Context, path: String, points: Int): FloatArray? {
+        if (points <= 0) return null
+        val startTime = SystemClock.uptimeMillis()
+        val extractor = MediaExtractor()
+        var decoder: MediaCodec? = null
+        var reducer: WaveformReducer? = null
+        try {
+            extractor.setDataSource(context, Uri.parse(path), null)
+            val track = (0 until extractor.trackCount).firstOrNull {
+                extractor.getTrackFormat(it).getString(MediaFormat.KEY_MIME)?.contains("audio") == true
+            } ?: return null
+            val format = extractor.getTrackFormat(track)
+            if (!format.containsKey(MediaFormat.KEY_DURATION)) return null
+            val durationUs = format.getLong(MediaFormat.KEY_DURATION)
+            if (durationUs < MIN_DURATION_US) return null
+            extractor.selectTrack(track)
+
+            val codec = MediaCodec.createDecoderByType(format.getString(MediaFormat.KEY_MIME) ?: return null)
+            decoder = codec
+            codec.configure(format, null, null, 0)
+            codec.start()
+
+            val windows = minOf(points, MAX_WINDOWS)
+            val levels = FloatArray(windows)
+            val rms = FloatArray(1)
+            val info = MediaCodec.BufferInfo()
+            var pcmEncodingBit = 16
+            for (window in 0 until windows) {
+                if (SystemClock.uptimeMillis() - startTime > MAX_PREVIEW_MS) return null
+                // The middle of each window's share of the file
+                extractor.seekTo(durationUs * (2 * window + 1) / (2 * windows), MediaExtractor.SEEK_TO_CLOSEST_SYNC)
+                if (window > 0) codec.flush()
+                reducer?.reset()
+                var inputEof = false
+                // The first buffer after a flush is decoder warm-up, often near silence
+                var isWarmUp = true
+                var tries = 0
+                while (tries++ < MAX_TRIES_PER_WINDOW) {
+                    if (!inputEof) {
+                        val index = codec.dequeueInputBuffer(TIMEOUT_US)
+                        if (index >= 0) {
+                            val size = codec.getInputBuffer(index)?.let { extractor.readSampleData(it, 0) } ?: -1
+                            if (size > 0) {
+                                codec.queueInputBuffer(index, 0, size, extractor.sampleTime, 0)
+                                extractor.advance()
+                            } else {
+                                codec.queueInputBuffer(index, 0, 0, 0, MediaCodec.BUFFER_FLAG_END_OF_STREAM)
+                                inputEof = true
+                            }
+                        }
+                    }
+                    val index = codec.dequeueOutputBuffer(info, TIMEOUT_US)
+                    if (index == MediaCodec.INFO_OUTPUT_FORMAT_CHANGED) {
+                        val outputFormat = codec.outputFormat
+                        pcmEncodingBit = outputFormat.pcmEncodingBit()
+                        reducer?.release()
+                        reducer = WaveformReducer(outputFormat.getInteger(MediaFormat.KEY_CHANNEL_COUNT), WINDOW_FRAMES)
+                        continue
+                    }
+                    if (index < 0) continue
+                    val buffer = codec.getOutputBuffer(index)
+                    val current = reducer
+                    val isDone = if (!isWarmUp && buffer != null && current != null && info.size > 0) {
+                        current.processDirect(buffer, info.offset, info.size, pcmEncodingBit, rms, null, 1) > 0
+                    } else {
+                        false
+                    }
+                    isWarmUp = false
+                    codec.releaseOutputBuffer(index, false)
+                    if (isDone) {
+                        levels[window] = rms[0]
+                        break
+                    }
+                    if (info.isEof()) break
+                }
+            }
+            return FloatArray(points) { levels[it * windows / points] }
+        } catch (e: Exception) {
+            Log.e(Constants.LOG_TAG, "Failed to preview $path", e)
+            return null
+        } finally {
+            reducer?.release()
+            try {
+                decoder?.stop()
+            } catch (e: IllegalStateException) {
+                // Never started
+            }
+            decoder?.release()
+            extractor.release()
+        }
+    }
+}
@@ -0,0 +1,114 @@
+package com.audiowaveform
+
+import java.nio.ByteBuffer
+
+/**
+ * Kotlin handle to the shared C++ reduction kernel (cpp/WaveformReducer.h).
+ * Keeps its bucket accumulator between calls, so buckets may span decoder buffers.
+ * With [ChannelMode.PerChannel] every bucket takes [valuesPerBucket] entries of the outputs.
+ */
+class WaveformReducer(channels: Int, framesPerBucket: Long, channelMode: ChannelMode = ChannelMode.Mixdown) {
+    private var handle: Long = nativeCreate(channels, framesPerBucket, channelMode.value)
+
+    /** Output values per bucket: one per channel with [ChannelMode.PerChannel], otherwise one */
+    val valuesPerBucket = if (channelMode == ChannelMode.PerChannel) maxOf(1, channels) else 1
+
+    /**
+     * Reduces [size] bytes of interleaved PCM from [data] and writes completed buckets to
+     * [rmsOut] (and [peakOut] when given), at most [capacity]. Returns the number of buckets written.
+     */
+    @Synchronized
+    fun process(
+        data: ByteArray,
+        size: Int,
+        pcmEncodingBit: Int,
+        rmsOut: FloatArray,
+        peakOut: FloatArray?,
+        capacity: Int
+    ): Int {
+        if (handle == 0L) return 0
+        return nativeProcess(handle, data, size, pcmEncodingBit, rmsOut, peakOut, clampCapacity(capacity, rmsOut, peakOut))
+    }
+
+    /**
+     * Same as [process] but reads [size] bytes starting at [offset] of a direct [buffer]
+     * in place, without copying it to the Java heap.
+     */
+    @Synchronized
+    fun processDirect(
+        buffer: ByteBuffer,
+        offset: Int,
+        size: Int,
+        pcmEncodingBit: Int,
+        rmsOut: FloatArray,
+        peakOut: FloatArray?,
+        capacity: Int
+    ): Int {
+        if (handle == 0L) return 0
+        return nativeProcessDirect(handle, buffer, offset, size, pcmEncodingBit, rmsOut, peakOut, clampCapacity(capacity, rmsOut, peakOut))
+    }
+
+    @Synchronized
+    fun maxBucketsFor(size: Int, pcmEncodingBit: Int): Int {
+        if (handle == 0L) return 0
+        return nativeMaxBucketsFor(handle, size, pcmEncodingBit)
+    }
+
+    /** Drops the partially filled bucket */
+    @Synchronized
+    fun reset() {
+        if (handle == 0L) return
+        nativeReset(handle)
+    }
+
+    @Synchronized
+    fun release() {
+        if (handle == 0L) return
+        nativeDestroy(handle)
+        handle = 0L
+    }
+
+    private fun clampCapacity(capacity: Int, rmsOut: FloatArray, peakOut: FloatArray?): Int {
+        return minOf(capacity, rmsOut.size / valuesPerBucket, (peakOut?.size ?: Int.MAX_VALUE) / valuesPerBucket)
+    }
+
+    private external fun nativeCreate(channels: Int, framesPerBucket: Long, mode: Int): Long
+    private external fun nativeDestroy(handle: Long)
+    private external fun nativeProcess(
+        handle: Long,
+        data: ByteArray,
+        size: Int,
+        encodingBit: Int,
+        rmsOut: FloatArray,
+        peakOut: FloatArray?,
+        capacity: Int
+    ): Int
+    private external fun nativeProcessDirect(
+        handle: Long,
+        buffer: ByteBuffer,
+        offset: Int,
+        size: Int,
+        encodingBit: Int,
+        rmsOut: FloatArray,
+        peakOut: FloatArray?,
+        capacity: Int
+    ): Int
+    private external fun nativeReset(handle: Long)
+    private external fun nativeMaxBucketsFor(handle: Long, size: Int, encodingBit: Int): Int
+
+    companion object {
+        init {
+            System.loadLibrary("audiowaveform")
+        }
+
+        /** Largest of [values] at or above [threshold], 1 if there is none */
+        fun normalizationMax(values: FloatArray, threshold: Float): Float = nativeNormalizationMax(values, values.size, threshold)
+
+        /** Scales [values] in place so that [maxValue] becomes [scale], zeroing values below [threshold] */
+        fun normalize(values: FloatArray, maxValue: Float, scale: Float, threshold: Float) =
+            nativeNormalize(values, values.size, maxValue, scale, threshold)
+
+        @JvmStatic private external fun nativeNormalizationMax(values: FloatArray, count: Int, threshold: Float): Float
+        @JvmStatic private external fun nativeNormalize(values: FloatArray, count: Int, maxValue: Float, scale: Float, threshold: Float)
+    }
+}
@@ -0,0 +1,189 @@
+package com.audiowaveform
+
+import android.content.Context
+import android.graphics.Canvas
+import android.graphics.Color
+import android.graphics.Paint
+import android.graphics.Path
+import android.graphics.RectF
+import android.view.Choreographer
+import android.view.View
+import com.facebook.react.uimanager.PixelUtil
+import kotlin.math.ceil
+
+/**
+ * Draws a whole waveform as candles in one pass, with the candles before [progress] in
+ * [scrubColor]. The candle path is only rebuilt when the samples or the geometry change, so a
+ * progress update is a clip and two path draws. While [playing], the playhead is extrapolated
+ * from the last progress and [progressRate], and the view only redraws when it reaches the
+ * next candle.
+ */
+class WaveformView(context: Context) : View(context) {
+    private var samples = FloatArray(0)
+    private val candlePath = Path()
+    private val candleRect = RectF()
+    private var isPathDirty = true
+    private val wavePaint = Paint(Paint.ANTI_ALIAS_FLAG).apply { color = DEFAULT_WAVE_COLOR }
+    private val scrubPaint = Paint(Paint.ANTI_ALIAS_FLAG).apply { color = DEFAULT_SCRUB_COLOR }
+
+    /** Candle width and gap in pixels */
+    var candleWidth = 0f
+        set(value) {
+            field = value
+            invalidatePath()
+        }
+    var candleSpace = 0f
+        set(value) {
+            field = value
+            invalidatePath()
+        }
+    var candleHeightScale = 3f
+        set(value) {
+            field = value
+            invalidatePath()
+        }
+
+    /** Played fraction of the waveform, from 0 to 1, at [progressTimestamp] */
+    var progress = 0f
+        set(value) {
+            field = value.coerceIn(0f, 1f)
+            progressSetAt = System.currentTimeMillis()
+            updatePlayhead()
+        }
+
+    /** Wall clock time in milliseconds the [progress] was measured at, 0 for when it was set */
+    var progressTimestamp = 0.0
+        set(value) {
+            field = value
+            updatePlayhead()
+        }
+
+    /** Fraction of the waveform played per millisecond while [playing] */
+    var progressRate = 0.0
+        set(value) {
+            field = value
+            updatePlayhead()
+        }
+
+    /** While true the playhead is extrapolated from [progress] on every frame */
+    var playing = false
+        set(value) {
+            field = value
+            updatePlayhead()
+        }
+
+    private var progressSetAt = 0L
+    private var playedCandles = -1
+    private var isFrameCallbackPosted = false
+    private val frameCallback = Choreographer.FrameCallback {
+        isFrameCallbackPosted = false
+        updatePlayhead()
+    }
+
+    var waveColor: Int
+        get() = wavePaint.color
+        set(value) {
+            wavePaint.color = value
+            invalidate()
+        }
+    var scrubColor: Int
+        get() = scrubPaint.color
+        set(value) {
+            scrubPaint.color = value
+            invalidate()
+        }
+
+    fun setSamples(values: FloatArray) {
+        samples = values
+        playedCandles = -1
+        invalidatePath()
+    }
+
+    private fun currentProgress(): Double {
+        if (!playing || progressRate <= 0.0) return progress.toDouble()
+        val anchor = if (progressTimestamp > 0.0) progressTimestamp else progressSetAt.toDouble()
+        val elapsed = (System.currentTimeMillis() - anchor).coerceAtLeast(0.0)
+        return (progress + elapsed * progressRate).coerceIn(0.0, 1.0)
+    }
+
+    /**
+     * Redraws when the extrapolated playhead reached another candle, and keeps following it on
+     * vsync while playing. Rare position events then still move the scrub color every frame.
+     */
+    private fun updatePlayhead() {
+        // A candle is played as a whole once the progress passed its start, like WaveformCandle
+        val played = ceil(currentProgress() * samples.size).toInt()
+        if (played != playedCandles) {
+            playedCandles = played
+            invalidate()
+        }
+        if (playing && progressRate > 0.0 && isAttachedToWindow && !isFrameCallbackPosted) {
+            isFrameCallbackPosted = true
+            Choreographer.getInstance().postFrameCallback(frameCallback)
+        }
+    }
+
+    override fun onAttachedToWindow() {
+        super.onAttachedToWindow()
+        updatePlayhead()
+    }
+
+    override fun onDetachedFromWindow() {
+        Choreographer.getInstance().removeFrameCallback(frameCallback)
+        isFrameCallbackPosted = false
+        super.onDetachedFromWindow()
+    }
+
+    private fun invalidatePath() {
+        isPathDirty = true
+        invalidate()
+    }
+
+    override fun onSizeChanged(w: Int, h: Int, oldw: Int, oldh: Int) {
+        super.onSizeChanged(w, h, oldw, oldh)
+        isPathDirty = true
+    }
+
+    /** Same geometry as the JS WaveformCandle: centered, at least as tall as wide, fully rounded */
+    private fun rebuildPath() {
+        candlePath.rewind()
+        val maxHeight = (height - VERTICAL_INSET).coerceAtLeast(0f)
+        val step = candleWidth + candleSpace
+        val radius = candleWidth / 2f
+        for (index in samples.indices) {
+            val amplitude = samples[index].takeUnless { it.isNaN() } ?: 0f
+            val candleHeight = (amplitude * maxHeight * candleHeightScale).coerceIn(candleWidth.coerceAtMost(maxHeight), maxHeight)
+            val left = index * step
+            if (left > width) break
+            val top = (height - candleHeight) / 2f
+            candleRect.set(left, top, left + candleWidth, top + candleHeight)
+            candlePath.addRoundRect(candleRect, radius, radius, Path.Direction.CW)
+        }
+        isPathDirty = false
+    }
+
+    override fun onDraw(canvas: Canvas) {
+        super.onDraw(canvas)
+        if (samples.isEmpty() || candleWidth <= 0f) return
+        if (isPathDirty) rebuildPath()
+
+        if (playedCandles < 0) playedCandles = ceil(currentProgress() * samples.size).toInt()
+        val splitX = playedCandles * (candleWidth + candleSpace)
+        var save = canvas.save()
+        canvas.clipRect(0f, 0f, splitX, height.toFloat())
+        canvas.drawPath(candlePath, scrubPaint)
+        canvas.restoreToCount(save)
+        save = canvas.save()
+        canvas.clipRect(splitX, 0f, width.toFloat(), height.toFloat())
+        canvas.drawPath(candlePath, wavePaint)
+        canvas.restoreToCount(save)
+    }
+
+    companion object {
+        // WaveformCandle keeps 10 points of the container free
+        private val VERTICAL_INSET = PixelUtil.toPixelFromDIP(10f)
+        // Colors.waveStickBackground and Colors.waveStickCompleteBackground of the JS theme
+        val DEFAULT_WAVE_COLOR = Color.parseColor("#545454")
+        val DEFAULT_SCRUB_COLOR = Color.parseColor("#7b7b7b")
+    }
+}
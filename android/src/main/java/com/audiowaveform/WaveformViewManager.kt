@@ -0,0 +1,71 @@
+package com.audiowaveform
+
+import com.facebook.react.bridge.ReadableArray
+import com.facebook.react.uimanager.PixelUtil
+import com.facebook.react.uimanager.SimpleViewManager
+import com.facebook.react.uimanager.ThemedReactContext
+import com.facebook.react.uimanager.annotations.ReactProp
+
+class WaveformViewManager : SimpleViewManager<WaveformView>() {
+    override fun getName() = NAME
+
+    override fun createViewInstance(reactContext: ThemedReactContext) = WaveformView(reactContext)
+
+    @ReactProp(name = "samples")
+    fun setSamples(view: WaveformView, samples: ReadableArray?) {
+        val values = FloatArray(samples?.size() ?: 0)
+        for (index in values.indices) {
+            values[index] = samples!!.getDouble(index).toFloat()
+        }
+        view.setSamples(values)
+    }
+
+    @ReactProp(name = "progress", defaultFloat = 0f)
+    fun setProgress(view: WaveformView, progress: Float) {
+        view.progress = progress
+    }
+
+    @ReactProp(name = "progressTimestamp", defaultDouble = 0.0)
+    fun setProgressTimestamp(view: WaveformView, timestamp: Double) {
+        view.progressTimestamp = timestamp
+    }
+
+    @ReactProp(name = "progressRate", defaultDouble = 0.0)
+    fun setProgressRate(view: WaveformView, rate: Double) {
+        view.progressRate = rate
+    }
+
+    @ReactProp(name = "playing", defaultBoolean = false)
+    fun setPlaying(view: WaveformView, playing: Boolean) {
+        view.playing = playing
+    }
+
+    @ReactProp(name = "candleWidth", defaultFloat = 5f)
+    fun setCandleWidth(view: WaveformView, candleWidth: Float) {
+        view.candleWidth = PixelUtil.toPixelFromDIP(candleWidth)
+    }
+
+    @ReactProp(name = "candleSpace", defaultFloat = 2f)
+    fun setCandleSpace(view: WaveformView, candleSpace: Float) {
+        view.candleSpace = PixelUtil.toPixelFromDIP(candleSpace)
+    }
+
+    @ReactProp(name = "candleHeightScale", defaultFloat = 3f)
+    fun setCandleHeightScale(view: WaveformView, candleHeightScale: Float) {
+        view.candleHeightScale = candleHeightScale
+    }
+
+    @ReactProp(name = "waveColor", customType = "Color")
+    fun setWaveColor(view: WaveformView, color: Int?) {
+        view.waveColor = color ?: WaveformView.DEFAULT_WAVE_COLOR
+    }
+
+    @ReactProp(name = "scrubColor", customType = "Color")
+    fun setScrubColor(view: WaveformView, color: Int?) {
+        view.scrubColor = color ?: WaveformView.DEFAULT_SCRUB_COLOR
+    }
+
+    companion object {
+        const val NAME = "AudioWaveformView"
+    }
+}
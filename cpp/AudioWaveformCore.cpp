@@ -0,0 +1,112 @@
+//
+//  AudioWaveformCore.cpp
+//  AudioWaveform
+//
+
+#include "AudioWaveformCore.h"
+#include "LevelHistory.h"
+#include "PeakCache.h"
+#include "PeakPyramid.h"
+#include "WaveformBufferStore.h"
+#include "WaveformReducer.h"
+
+#include <algorithm>
+
+using audiowaveform::ChannelMode;
+using audiowaveform::PeakCache;
+using audiowaveform::PeakLevel;
+using audiowaveform::PeakPyramid;
+using audiowaveform::SampleFormat;
+using audiowaveform::WaveformReducer;
+
+struct AWReducer {
+  WaveformReducer reducer;
+};
+
+struct AWPyramid {
+  PeakPyramid pyramid;
+};
+
+AWReducer *AWReducerCreate(int channels, int64_t framesPerBucket, AWChannelMode mode) {
+  return new AWReducer{WaveformReducer(channels, framesPerBucket, static_cast<ChannelMode>(mode))};
+}
+
+void AWReducerDestroy(AWReducer *reducer) { delete reducer; }
+
+size_t AWReducerProcess(AWReducer *reducer, const void *data, size_t byteCount, AWSampleFormat format,
+                        float *rmsOut, float *peakOut, size_t capacity) {
+  return reducer->reducer.process(data, byteCount, static_cast<SampleFormat>(format), rmsOut, peakOut,
+                                  capacity);
+}
+
+size_t AWReducerProcessPlanar(AWReducer *reducer, const float *const *channels, size_t frameCount,
+                              float *rmsOut, float *peakOut, size_t capacity) {
+  return reducer->reducer.processPlanar(channels, frameCount, rmsOut, peakOut, capacity);
+}
+
+size_t AWReducerValuesPerBucket(const AWReducer *reducer) { return reducer->reducer.valuesPerBucket(); }
+
+size_t AWReducerFlush(AWReducer *reducer, float *rmsOut, float *peakOut) {
+  return reducer->reducer.flush(rmsOut, peakOut);
+}
+
+void AWReduceBlock(const void *data, size_t frameCount, int channels, AWSampleFormat format,
+                   float *rmsOut, float *peakOut) {
+  audiowaveform::reduceBlock(data, frameCount, channels, static_cast<SampleFormat>(format), rmsOut, peakOut);
+}
+
+float AWNormalizationMax(const float *values, size_t count, float threshold) {
+  return audiowaveform::normalizationMax(values, count, threshold);
+}
+
+void AWNormalize(float *values, size_t count, float maxValue, float scale, float threshold) {
+  audiowaveform::normalize(values, count, maxValue, scale, threshold);
+}
+
+bool AWPeakCacheLoad(const char *directory, const char *sourcePath, size_t bucketCount, float *rmsOut,
+                     float *peakOut) {
+  PeakLevel level;
+  if (!PeakCache(directory).load(sourcePath, bucketCount, level)) return false;
+  std::copy(level.rms.begin(), level.rms.end(), rmsOut);
+  std::copy(level.peak.begin(), level.peak.end(), peakOut);
+  return true;
+}
+
+bool AWPeakCacheStore(const char *directory, const char *sourcePath, const float *rms, const float *peak,
+                      size_t count) {
+  PeakLevel level;
+  level.rms.assign(rms, rms + count);
+  level.peak.assign(peak, peak + count);
+  return PeakCache(directory).store(sourcePath, level);
+}
+
+AWPyramid *AWPyramidCreate(int channels, int64_t totalFrames, bool planar) {
+  return new AWPyramid{PeakPyramid(channels, totalFrames, planar)};
+}
+
+void AWPyramidDestroy(AWPyramid *pyramid) { delete pyramid; }
+
+void AWPyramidProcess(AWPyramid *pyramid, const void *data, size_t byteCount, AWSampleFormat format) {
+  pyramid->pyramid.process(data, byteCount, static_cast<SampleFormat>(format));
+}
+
+void AWPyramidProcessPlanar(AWPyramid *pyramid, int channel, const float *samples, size_t frameCount) {
+  pyramid->pyramid.processPlanar(channel, samples, frameCount);
+}
+
+bool AWPyramidStoreInCache(AWPyramid *pyramid, const char *directory, const char *sourcePath, const float *rms,
+                           const float *peak, size_t count) {
+  pyramid->pyramid.finish();
+  std::vector<PeakLevel> levels;
+  if (count > 0) levels.push_back(PeakLevel{std::vector<float>(rms, rms + count), std::vector<float>(peak, peak + count)});
+  levels.insert(levels.end(), pyramid->pyramid.levels().begin(), pyramid->pyramid.levels().end());
+  return PeakCache(directory).store(sourcePath, levels);
+}
+
+int64_t AWBufferStorePut(const float *values, size_t count, bool isResult) {
+  return audiowaveform::WaveformBufferStore::shared().put(std::vector<float>(values, values + count), isResult);
+}
+
+void AWLevelHistoryPush(float level) { audiowaveform::LevelHistory::recording().push(level); }
+
+void AWLevelHistoryClear(void) { audiowaveform::LevelHistory::recording().clear(); }
@@ -0,0 +1,92 @@
+//
+//  AudioWaveformCore.h
+//  AudioWaveform
+//
+//  C interface to the shared waveform core. Swift reaches it through
+//  AudioWaveform-Bridging-Header.h; Android uses the C++ classes over JNI.
+//
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Matches audiowaveform::SampleFormat.
+typedef enum {
+  AWSampleFormatUInt8 = 8,
+  AWSampleFormatInt16 = 16,
+  AWSampleFormatFloat32 = 32,
+} AWSampleFormat;
+
+/// Matches audiowaveform::ChannelMode.
+typedef enum {
+  AWChannelModeMixdown = 0,
+  AWChannelModeMax = 1,
+  AWChannelModePerChannel = 2,
+} AWChannelMode;
+
+typedef struct AWReducer AWReducer;
+
+AWReducer *AWReducerCreate(int channels, int64_t framesPerBucket, AWChannelMode mode);
+void AWReducerDestroy(AWReducer *reducer);
+size_t AWReducerProcess(AWReducer *reducer, const void *data, size_t byteCount, AWSampleFormat format,
+                        float *rmsOut, float *peakOut, size_t capacity);
+/// Planar float input, one pointer per channel of the reducer.
+size_t AWReducerProcessPlanar(AWReducer *reducer, const float *const *channels, size_t frameCount,
+                              float *rmsOut, float *peakOut, size_t capacity);
+/// Output values per bucket: the channel count with AWChannelModePerChannel, otherwise 1.
+size_t AWReducerValuesPerBucket(const AWReducer *reducer);
+size_t AWReducerFlush(AWReducer *reducer, float *rmsOut, float *peakOut);
+
+/// Reduces a whole block of interleaved PCM into a single RMS/peak pair.
+void AWReduceBlock(const void *data, size_t frameCount, int channels, AWSampleFormat format,
+                   float *rmsOut, float *peakOut);
+
+/// See audiowaveform::normalizationMax and audiowaveform::normalize.
+float AWNormalizationMax(const float *values, size_t count, float threshold);
+void AWNormalize(float *values, size_t count, float maxValue, float scale, float threshold);
+
+/// Loads `bucketCount` raw RMS and peak values of `sourcePath` from the peak
+/// cache in `directory` into the caller's arrays. Returns false on a miss.
+bool AWPeakCacheLoad(const char *directory, const char *sourcePath, size_t bucketCount, float *rmsOut,
+                     float *peakOut);
+
+/// Stores `count` raw RMS and peak values of `sourcePath` in the peak cache.
+bool AWPeakCacheStore(const char *directory, const char *sourcePath, const float *rms, const float *peak,
+                      size_t count);
+
+typedef struct AWPyramid AWPyramid;
+
+/// Creates a peak pyramid (cpp/PeakPyramid.h) for a source of `totalFrames`
+/// frames. `planar` selects deinterleaved float input, one channel at a time.
+AWPyramid *AWPyramidCreate(int channels, int64_t totalFrames, bool planar);
+void AWPyramidDestroy(AWPyramid *pyramid);
+void AWPyramidProcess(AWPyramid *pyramid, const void *data, size_t byteCount, AWSampleFormat format);
+void AWPyramidProcessPlanar(AWPyramid *pyramid, int channel, const float *samples, size_t frameCount);
+
+/// Finishes the pyramid and adds all of its levels to the peak cache, so later
+/// requests for other sample counts of `sourcePath` are served without decoding.
+/// `count` raw RMS and peak values of a direct reduction, if any, go into the
+/// same write.
+bool AWPyramidStoreInCache(AWPyramid *pyramid, const char *directory, const char *sourcePath, const float *rms,
+                           const float *peak, size_t count);
+
+/// Puts a copy of `count` floats into the buffer store (cpp/WaveformBufferStore.h)
+/// and returns the id JS takes it with. Progress slices may be dropped when JS
+/// falls behind, `isResult` buffers only once many are left untaken.
+int64_t AWBufferStorePut(const float *values, size_t count, bool isResult);
+
+/// Appends a live recording level to the recording history (cpp/LevelHistory.h).
+void AWLevelHistoryPush(float level);
+
+/// Empties the recording history, when a new recording starts.
+void AWLevelHistoryClear(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,65 @@
+//
+//  LevelHistory.cpp
+//  AudioWaveform
+//
+
+#include "LevelHistory.h"
+
+#include <algorithm>
+
+namespace audiowaveform {
+
+LevelHistory::LevelHistory(size_t capacity) : capacity_(std::max<size_t>(1, capacity)) {}
+
+LevelHistory &LevelHistory::recording() {
+  static LevelHistory history;
+  return history;
+}
+
+void LevelHistory::push(float level) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (levels_.size() < capacity_) {
+    levels_.push_back(level);
+  } else {
+    levels_[head_] = level;
+    head_ = (head_ + 1) % capacity_;
+  }
+  ++total_;
+}
+
+void LevelHistory::clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  levels_.clear();
+  head_ = 0;
+  total_ = 0;
+}
+
+void LevelHistory::setCapacity(size_t capacity) {
+  capacity = std::max<size_t>(1, capacity);
+  std::vector<float> kept = tail(capacity);
+  std::lock_guard<std::mutex> lock(mutex_);
+  levels_ = std::move(kept);
+  levels_.reserve(capacity);
+  capacity_ = capacity;
+  head_ = 0;
+}
+
+int64_t LevelHistory::total() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return total_;
+}
+
+std::vector<float> LevelHistory::tail(size_t count) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const size_t size = levels_.size();
+  count = std::min(count, size);
+  std::vector<float> result(count);
+  // Until the buffer is full head_ stays 0 and the levels are in order.
+  const size_t first = (head_ + size - count) % std::max<size_t>(1, size);
+  for (size_t i = 0; i < count; ++i) {
+    result[i] = levels_[(first + i) % size];
+  }
+  return result;
+}
+
+} // namespace audiowaveform
@@ -0,0 +1,54 @@
+//
+//  LevelHistory.h
+//  AudioWaveform
+//
+//  Fixed-capacity ring buffer of the live recording levels. The recorders
+//  push every level they emit; JS reads the tail it shows through the JSI
+//  binding (WaveformJsi.h) instead of keeping the history itself, so memory
+//  stays flat however long the recording runs.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace audiowaveform {
+
+class LevelHistory {
+public:
+  /// An hour of levels at the fastest recorder update rate (50 ms).
+  static constexpr size_t kDefaultCapacity = 72000;
+
+  explicit LevelHistory(size_t capacity = kDefaultCapacity);
+
+  /// The history of the recorder, shared by the natives and the JSI binding.
+  static LevelHistory &recording();
+
+  void push(float level);
+
+  /// Drops all levels, e.g. when a new recording starts.
+  void clear();
+
+  /// Changes the capacity, keeping the newest levels that still fit.
+  void setCapacity(size_t capacity);
+
+  /// Number of levels pushed since the last `clear`, including the ones the
+  /// ring buffer has overwritten. Lets readers tell whether anything changed.
+  int64_t total() const;
+
+  /// The newest `count` levels, oldest first; fewer if not that many are kept.
+  std::vector<float> tail(size_t count) const;
+
+private:
+  mutable std::mutex mutex_;
+  std::vector<float> levels_;
+  size_t capacity_;
+  // Index of the next write once the buffer is full, i.e. the oldest level
+  size_t head_ = 0;
+  int64_t total_ = 0;
+};
+
+} // namespace audiowaveform
@@ -0,0 +1,249 @@
+//
+//  PeakCache.cpp
+//  AudioWaveform
+//
+
+#include "PeakCache.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+
+namespace audiowaveform {
+
+namespace {
+
+constexpr char kMagic[4] = {'A', 'W', 'P', 'K'};
+constexpr uint32_t kVersion = 1;
+constexpr uint32_t kHasPeaks = 1u << 0;
+// Room for a full pyramid plus the resolutions requested directly; the oldest
+// level is dropped past this.
+constexpr size_t kMaxLevels = 32;
+// Guards against reading garbage sizes from a truncated or foreign file.
+constexpr uint32_t kMaxBucketCount = 1u << 24;
+// A level is only resampled when it has this many times the requested buckets,
+// which keeps the error at the bucket edges small; otherwise the finest is used.
+constexpr size_t kMinOversampling = 8;
+// Stripes of the lock that serializes updates of one cache file.
+constexpr size_t kLockStripes = 64;
+
+struct SourceStamp {
+  int64_t size = 0;
+  int64_t mtime = 0;
+};
+
+struct CacheFile {
+  SourceStamp stamp;
+  std::vector<PeakLevel> levels;
+};
+
+bool statSource(const std::string &path, SourceStamp &stamp) {
+  struct stat info {};
+  if (::stat(path.c_str(), &info) != 0) return false;
+  stamp.size = static_cast<int64_t>(info.st_size);
+  stamp.mtime = static_cast<int64_t>(info.st_mtime);
+  return true;
+}
+
+uint64_t fnv1a(const std::string &value) {
+  uint64_t hash = 1469598103934665603ull;
+  for (unsigned char c : value) {
+    hash ^= c;
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+// Process-wide, so PeakCache instances of the same directory on different
+// threads cannot interleave their read-modify-write of one file.
+std::mutex &lockFor(const std::string &cachePath) {
+  static std::array<std::mutex, kLockStripes> locks;
+  return locks[fnv1a(cachePath) % kLockStripes];
+}
+
+template <typename T>
+bool readValue(FILE *file, T &value) {
+  return std::fread(&value, sizeof(T), 1, file) == 1;
+}
+
+template <typename T>
+bool writeValue(FILE *file, const T &value) {
+  return std::fwrite(&value, sizeof(T), 1, file) == 1;
+}
+
+bool readFloats(FILE *file, std::vector<float> &values, uint32_t count) {
+  values.resize(count);
+  return count == 0 || std::fread(values.data(), sizeof(float), count, file) == count;
+}
+
+bool readCacheFile(const std::string &path, CacheFile &cache) {
+  FILE *file = std::fopen(path.c_str(), "rb");
+  if (file == nullptr) return false;
+
+  char magic[4];
+  uint32_t version = 0;
+  uint32_t levelCount = 0;
+  bool ok = std::fread(magic, 1, sizeof(magic), file) == sizeof(magic) &&
+            std::memcmp(magic, kMagic, sizeof(kMagic)) == 0 && readValue(file, version) &&
+            version == kVersion && readValue(file, cache.stamp.size) && readValue(file, cache.stamp.mtime) &&
+            readValue(file, levelCount) && levelCount <= kMaxLevels;
+
+  for (uint32_t i = 0; ok && i < levelCount; ++i) {
+    uint32_t bucketCount = 0;
+    uint32_t flags = 0;
+    PeakLevel level;
+    ok = readValue(file, bucketCount) && readValue(file, flags) && bucketCount <= kMaxBucketCount &&
+         readFloats(file, level.rms, bucketCount) &&
+         ((flags & kHasPeaks) == 0 || readFloats(file, level.peak, bucketCount));
+    if (ok) cache.levels.push_back(std::move(level));
+  }
+  std::fclose(file);
+  return ok;
+}
+
+bool writeCacheFile(const std::string &path, const CacheFile &cache) {
+  // Write next to the target and rename, so readers never see a partial file.
+  // The name is unique, a writer of another process never shares it.
+  std::string temporaryPath = path + ".XXXXXX";
+  const int descriptor = ::mkstemp(&temporaryPath[0]);
+  if (descriptor < 0) return false;
+  FILE *file = ::fdopen(descriptor, "wb");
+  if (file == nullptr) {
+    ::close(descriptor);
+    std::remove(temporaryPath.c_str());
+    return false;
+  }
+
+  bool ok = std::fwrite(kMagic, 1, sizeof(kMagic), file) == sizeof(kMagic) && writeValue(file, kVersion) &&
+            writeValue(file, cache.stamp.size) && writeValue(file, cache.stamp.mtime) &&
+            writeValue(file, static_cast<uint32_t>(cache.levels.size()));
+  for (const PeakLevel &level : cache.levels) {
+    if (!ok) break;
+    const auto bucketCount = static_cast<uint32_t>(level.size());
+    const uint32_t flags = level.peak.size() == level.rms.size() ? kHasPeaks : 0;
+    ok = writeValue(file, bucketCount) && writeValue(file, flags) &&
+         std::fwrite(level.rms.data(), sizeof(float), bucketCount, file) == bucketCount &&
+         ((flags & kHasPeaks) == 0 ||
+          std::fwrite(level.peak.data(), sizeof(float), bucketCount, file) == bucketCount);
+  }
+  ok = std::fclose(file) == 0 && ok;
+  if (!ok || std::rename(temporaryPath.c_str(), path.c_str()) != 0) {
+    std::remove(temporaryPath.c_str());
+    return false;
+  }
+  return true;
+}
+
+} // namespace
+
+PeakLevel resampleLevel(const PeakLevel &source, size_t bucketCount) {
+  const size_t sourceCount = source.size();
+  if (bucketCount == 0 || sourceCount == 0 || bucketCount >= sourceCount) return source;
+
+  const bool hasPeaks = source.peak.size() == sourceCount;
+  PeakLevel result;
+  result.rms.resize(bucketCount);
+  if (hasPeaks) result.peak.resize(bucketCount);
+
+  // Each target bucket spans `step` source buckets; the partial buckets at
+  // either edge are weighted by their overlap.
+  const double step = static_cast<double>(sourceCount) / static_cast<double>(bucketCount);
+  for (size_t i = 0; i < bucketCount; ++i) {
+    const double start = static_cast<double>(i) * step;
+    const double end = std::min(static_cast<double>(sourceCount), start + step);
+    const size_t first = static_cast<size_t>(start);
+    const size_t last = std::min(sourceCount, static_cast<size_t>(std::ceil(end)));
+    double sumOfSquares = 0.0;
+    float peak = 0.0f;
+    for (size_t j = first; j < last; ++j) {
+      const double weight = std::min(end, static_cast<double>(j) + 1.0) - std::max(start, static_cast<double>(j));
+      sumOfSquares += weight * source.rms[j] * source.rms[j];
+      if (hasPeaks) peak = std::max(peak, source.peak[j]);
+    }
+    result.rms[i] = static_cast<float>(std::sqrt(sumOfSquares / (end - start)));
+    if (hasPeaks) result.peak[i] = peak;
+  }
+  return result;
+}
+
+PeakCache::PeakCache(std::string directory) : directory_(std::move(directory)) {}
+
+bool PeakCache::load(const std::string &sourcePath, size_t bucketCount, PeakLevel &out) const {
+  SourceStamp stamp;
+  CacheFile cache;
+  if (bucketCount == 0 || !statSource(sourcePath, stamp) || !readCacheFile(cacheFileFor(sourcePath), cache)) {
+    return false;
+  }
+  if (cache.stamp.size != stamp.size || cache.stamp.mtime != stamp.mtime) return false;
+
+  // The exact resolution, otherwise the coarsest level fine enough to resample.
+  const PeakLevel *exact = nullptr;
+  const PeakLevel *closest = nullptr;
+  const PeakLevel *finest = nullptr;
+  for (const PeakLevel &level : cache.levels) {
+    if (level.size() < bucketCount || level.peak.size() != level.size()) continue;
+    if (level.size() == bucketCount) exact = &level;
+    if (finest == nullptr || level.size() > finest->size()) finest = &level;
+    if (level.size() >= bucketCount * kMinOversampling && (closest == nullptr || level.size() < closest->size())) {
+      closest = &level;
+    }
+  }
+  if (exact != nullptr) closest = exact;
+  if (closest == nullptr) closest = finest;
+  if (closest == nullptr) return false;
+
+  out = resampleLevel(*closest, bucketCount);
+  return true;
+}
+
+bool PeakCache::store(const std::string &sourcePath, const PeakLevel &level) const {
+  return store(sourcePath, std::vector<PeakLevel>{level});
+}
+
+bool PeakCache::store(const std::string &sourcePath, const std::vector<PeakLevel> &newLevels) const {
+  SourceStamp stamp;
+  if (newLevels.empty() || !statSource(sourcePath, stamp)) return false;
+  if (::mkdir(directory_.c_str(), 0755) != 0 && errno != EEXIST) return false;
+
+  const std::string path = cacheFileFor(sourcePath);
+  std::lock_guard<std::mutex> lock(lockFor(path));
+  CacheFile cache;
+  if (!readCacheFile(path, cache) || cache.stamp.size != stamp.size || cache.stamp.mtime != stamp.mtime) {
+    cache = CacheFile{};
+  }
+  cache.stamp = stamp;
+
+  auto &levels = cache.levels;
+  for (const PeakLevel &level : newLevels) {
+    if (level.size() == 0) continue;
+    levels.erase(std::remove_if(levels.begin(), levels.end(),
+                                [&](const PeakLevel &existing) { return existing.size() == level.size(); }),
+                 levels.end());
+    levels.push_back(level);
+  }
+  if (levels.size() > kMaxLevels) levels.erase(levels.begin(), levels.end() - kMaxLevels);
+
+  return writeCacheFile(path, cache);
+}
+
+void PeakCache::remove(const std::string &sourcePath) const {
+  const std::string path = cacheFileFor(sourcePath);
+  std::lock_guard<std::mutex> lock(lockFor(path));
+  std::remove(path.c_str());
+}
+
+std::string PeakCache::cacheFileFor(const std::string &sourcePath) const {
+  char name[32];
+  std::snprintf(name, sizeof(name), "%016llx.awpk", static_cast<unsigned long long>(fnv1a(sourcePath)));
+  return directory_ + "/" + name;
+}
+
+} // namespace audiowaveform
@@ -0,0 +1,58 @@
+//
+//  PeakCache.h
+//  AudioWaveform
+//
+//  Persistent multi-resolution peak cache, in the spirit of audiowaveform's
+//  .dat files. One file per source, keyed by path, size and mtime.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace audiowaveform {
+
+/// Raw (un-normalized) RMS and peak values of one resolution.
+struct PeakLevel {
+  std::vector<float> rms;
+  std::vector<float> peak;
+
+  size_t size() const { return rms.size(); }
+};
+
+/// Reduces `source` to `bucketCount` buckets. RMS values are combined as the
+/// root of the mean of squares, weighted by overlap, and peaks as the maximum,
+/// so the result is what a direct reduction at that resolution would give, up
+/// to bucket alignment.
+PeakLevel resampleLevel(const PeakLevel &source, size_t bucketCount);
+
+class PeakCache {
+public:
+  explicit PeakCache(std::string directory);
+
+  /// Looks up `bucketCount` buckets for `sourcePath`. Serves an exact level or
+  /// resamples a sufficiently finer one. Returns false on a miss or when the
+  /// source file changed since it was cached.
+  bool load(const std::string &sourcePath, size_t bucketCount, PeakLevel &out) const;
+
+  /// Adds `level` to the cache file of `sourcePath`, replacing a level of the
+  /// same size and dropping the file's other levels if the source changed.
+  /// Stores of the same file are serialized within the process.
+  bool store(const std::string &sourcePath, const PeakLevel &level) const;
+
+  /// Same as `store` for several levels at once, such as a whole pyramid.
+  bool store(const std::string &sourcePath, const std::vector<PeakLevel> &levels) const;
+
+  /// Removes the cache file of `sourcePath`, if any.
+  void remove(const std::string &sourcePath) const;
+
+private:
+  std::string cacheFileFor(const std::string &sourcePath) const;
+
+  std::string directory_;
+};
+
+} // namespace audiowaveform
@@ -0,0 +1,153 @@
+//
+//  PeakPyramid.cpp
+//  AudioWaveform
+//
+
+#include "PeakPyramid.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace audiowaveform {
+
+namespace {
+
+constexpr int64_t kMinBaseFramesPerBucket = 256;
+constexpr int64_t kMaxBaseBuckets = 1 << 16;
+// Coarser levels stop once a level fits in this many buckets.
+constexpr size_t kMinLevelBuckets = 32;
+// Matches the oversampling PeakCache::load asks of a level before resampling it.
+constexpr size_t kMinOversampling = 8;
+
+// Halves `level`, whose final bucket holds `lastWeight` of a full bucket's
+// frames. Squares are combined weighted by frames, so a short final bucket
+// counts for what it holds; `lastWeight` becomes that of the halved level.
+PeakLevel halve(const PeakLevel &level, double &lastWeight) {
+  const size_t size = level.size();
+  const size_t count = (size + 1) / 2;
+  PeakLevel result;
+  result.rms.resize(count);
+  result.peak.resize(count);
+  double weight = 1.0;
+  for (size_t i = 0; i < count; ++i) {
+    const size_t first = i * 2;
+    const size_t last = std::min(first + 1, size - 1);
+    const double a = level.rms[first];
+    const double b = level.rms[last];
+    const double firstWeight = first + 1 == size ? lastWeight : 1.0;
+    const double secondWeight = last + 1 == size ? lastWeight : 1.0;
+    if (last == first) {
+      result.rms[i] = static_cast<float>(a);
+      weight = firstWeight / 2.0;
+    } else {
+      weight = firstWeight + secondWeight;
+      result.rms[i] = static_cast<float>(std::sqrt((firstWeight * a * a + secondWeight * b * b) / weight));
+      weight /= 2.0;
+    }
+    result.peak[i] = std::max(level.peak[first], level.peak[last]);
+  }
+  lastWeight = weight;
+  return result;
+}
+
+} // namespace
+
+int64_t PeakPyramid::baseFramesPerBucket(int64_t totalFrames) {
+  int64_t framesPerBucket = kMinBaseFramesPerBucket;
+  while (totalFrames / framesPerBucket > kMaxBaseBuckets) framesPerBucket *= 2;
+  return framesPerBucket;
+}
+
+PeakPyramid::PeakPyramid(int channels, int64_t totalFrames, bool planar)
+    : channels_(std::max(1, channels)), framesPerBucket_(baseFramesPerBucket(totalFrames)) {
+  const size_t reducerCount = planar ? static_cast<size_t>(channels_) : 1;
+  const int reducerChannels = planar ? 1 : channels_;
+  const size_t expectedBuckets = static_cast<size_t>(std::max<int64_t>(0, totalFrames) / framesPerBucket_) + 1;
+  for (size_t i = 0; i < reducerCount; ++i) {
+    reducers_.emplace_back(reducerChannels, framesPerBucket_);
+    PeakLevel partial;
+    partial.rms.reserve(expectedBuckets);
+    partial.peak.reserve(expectedBuckets);
+    partials_.push_back(std::move(partial));
+  }
+}
+
+void PeakPyramid::process(const void *data, size_t byteCount, SampleFormat format) {
+  if (finished_ || reducers_.size() != 1) return;
+  append(partials_[0], reducers_[0], data, byteCount, format);
+}
+
+void PeakPyramid::processPlanar(int channel, const float *samples, size_t frameCount) {
+  if (finished_ || channel < 0 || static_cast<size_t>(channel) >= reducers_.size() ||
+      reducers_[channel].channels() != 1) {
+    return;
+  }
+  append(partials_[channel], reducers_[channel], samples, frameCount * sizeof(float), SampleFormat::Float32);
+}
+
+void PeakPyramid::append(PeakLevel &target, WaveformReducer &reducer, const void *data, size_t byteCount,
+                         SampleFormat format) {
+  const size_t capacity = reducer.maxBucketsFor(byteCount, format);
+  if (rmsScratch_.size() < capacity) {
+    rmsScratch_.resize(capacity);
+    peakScratch_.resize(capacity);
+  }
+  const size_t written =
+      reducer.process(data, byteCount, format, rmsScratch_.data(), peakScratch_.data(), capacity);
+  target.rms.insert(target.rms.end(), rmsScratch_.begin(), rmsScratch_.begin() + written);
+  target.peak.insert(target.peak.end(), peakScratch_.begin(), peakScratch_.begin() + written);
+}
+
+void PeakPyramid::finish() {
+  if (finished_) return;
+  finished_ = true;
+
+  // Every reducer is fed the same frames, so the first one's partial bucket
+  // tells what share of a full bucket the final base bucket holds
+  double lastWeight = static_cast<double>(reducers_[0].framesInBucket()) / static_cast<double>(framesPerBucket_);
+  if (lastWeight == 0.0) lastWeight = 1.0;
+  for (size_t i = 0; i < reducers_.size(); ++i) {
+    float rms = 0.0f;
+    float peak = 0.0f;
+    if (reducers_[i].flush(&rms, &peak) == 1) {
+      partials_[i].rms.push_back(rms);
+      partials_[i].peak.push_back(peak);
+    }
+  }
+
+  // Planar channels are mixed by power, the same as an interleaved reduction:
+  // the squares of every channel are summed, then the root of their mean taken.
+  PeakLevel base = std::move(partials_[0]);
+  if (partials_.size() > 1) {
+    for (float &value : base.rms) value *= value;
+    for (size_t channel = 1; channel < partials_.size(); ++channel) {
+      const PeakLevel &partial = partials_[channel];
+      const size_t count = std::min(base.size(), partial.size());
+      base.rms.resize(count);
+      base.peak.resize(count);
+      for (size_t i = 0; i < count; ++i) {
+        base.rms[i] += partial.rms[i] * partial.rms[i];
+        base.peak[i] = std::max(base.peak[i], partial.peak[i]);
+      }
+    }
+    for (float &value : base.rms) value = std::sqrt(value / static_cast<float>(partials_.size()));
+  }
+  partials_.clear();
+  if (base.size() == 0) return;
+
+  levels_.push_back(std::move(base));
+  while (levels_.back().size() > kMinLevelBuckets) {
+    levels_.push_back(halve(levels_.back(), lastWeight));
+  }
+}
+
+PeakLevel PeakPyramid::resample(size_t bucketCount) const {
+  if (levels_.empty()) return PeakLevel{};
+  const PeakLevel *closest = &levels_.front();
+  for (const PeakLevel &level : levels_) {
+    if (level.size() >= bucketCount * kMinOversampling) closest = &level;
+  }
+  return resampleLevel(*closest, bucketCount);
+}
+
+} // namespace audiowaveform
@@ -0,0 +1,64 @@
+//
+//  PeakPyramid.h
+//  AudioWaveform
+//
+//  Mipmap-style peak pyramid. The base level buckets a power-of-two number of
+//  frames and every further level halves the resolution, so any later sample
+//  count can be resampled from the closest level without decoding again.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "PeakCache.h"
+#include "WaveformReducer.h"
+
+namespace audiowaveform {
+
+class PeakPyramid {
+public:
+  /// Frames per base bucket for a source of `totalFrames`: the smallest power
+  /// of two, at least 256, that keeps the base level within 65536 buckets.
+  static int64_t baseFramesPerBucket(int64_t totalFrames);
+
+  /// `planar` selects one reducer per channel for deinterleaved input.
+  PeakPyramid(int channels, int64_t totalFrames, bool planar = false);
+
+  /// Feeds interleaved PCM.
+  void process(const void *data, size_t byteCount, SampleFormat format);
+
+  /// Feeds one channel of deinterleaved float PCM. Every channel must be fed
+  /// the same frames.
+  void processPlanar(int channel, const float *samples, size_t frameCount);
+
+  /// Flushes the partial bucket and builds the coarser levels. Idempotent.
+  void finish();
+
+  /// Levels from the finest (base) to the coarsest. Empty before `finish`.
+  const std::vector<PeakLevel> &levels() const { return levels_; }
+
+  int64_t framesPerBucket() const { return framesPerBucket_; }
+
+  /// Resamples the coarsest level with a few times `bucketCount` buckets, or
+  /// the base level when none is fine enough.
+  PeakLevel resample(size_t bucketCount) const;
+
+private:
+  void append(PeakLevel &target, WaveformReducer &reducer, const void *data, size_t byteCount,
+              SampleFormat format);
+
+  int channels_;
+  int64_t framesPerBucket_;
+  bool finished_ = false;
+  std::vector<WaveformReducer> reducers_;
+  // One accumulating base level per reducer; merged into levels_ by finish().
+  std::vector<PeakLevel> partials_;
+  std::vector<float> rmsScratch_;
+  std::vector<float> peakScratch_;
+  std::vector<PeakLevel> levels_;
+};
+
+} // namespace audiowaveform
@@ -0,0 +1,55 @@
+//
+//  WaveformBufferStore.cpp
+//  AudioWaveform
+//
+
+#include "WaveformBufferStore.h"
+
+namespace audiowaveform {
+
+namespace {
+
+constexpr int64_t kMaxSafeId = (int64_t{1} << 53) - 1;
+
+} // namespace
+
+WaveformBufferStore &WaveformBufferStore::shared() {
+  static WaveformBufferStore store;
+  return store;
+}
+
+int64_t WaveformBufferStore::put(std::vector<float> values, bool isResult) {
+  auto buffer = std::make_shared<std::vector<float>>(std::move(values));
+  std::lock_guard<std::mutex> lock(mutex_);
+  const int64_t id = nextId_;
+  nextId_ = nextId_ == kMaxSafeId ? 1 : nextId_ + 1;
+  buffers_[id] = Entry{std::move(buffer), isResult};
+  Queue &queue = isResult ? results_ : progress_;
+  queue.order.push_back(id);
+  ++queue.count;
+  evict(queue, isResult ? kMaxResults : kMaxBuffers);
+  return id;
+}
+
+void WaveformBufferStore::evict(Queue &queue, size_t limit) {
+  while (queue.count > limit) {
+    // Taken ids are skipped, only a buffer still stored counts against the limit
+    if (buffers_.erase(queue.order.front()) > 0) --queue.count;
+    queue.order.pop_front();
+  }
+  // Bounds the taken ids left behind when JS keeps up
+  while (queue.order.size() > limit * 2 && buffers_.count(queue.order.front()) == 0) queue.order.pop_front();
+}
+
+std::shared_ptr<std::vector<float>> WaveformBufferStore::take(int64_t id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = buffers_.find(id);
+  if (it == buffers_.end()) return nullptr;
+  Entry entry = std::move(it->second);
+  buffers_.erase(it);
+  // A taken buffer's id stays in its queue until it ages out
+  --(entry.isResult ? results_ : progress_).count;
+  return std::move(entry.values);
+}
+
+} // namespace audiowaveform
@@ -0,0 +1,65 @@
+//
+//  WaveformBufferStore.h
+//  AudioWaveform
+//
+//  Hands float buffers from the native extractors to JS without boxing them
+//  into bridge arrays. Natives put a buffer and pass its id over the bridge;
+//  JS takes it through the JSI binding (WaveformJsi.h) as an ArrayBuffer
+//  backed by the same memory.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace audiowaveform {
+
+class WaveformBufferStore {
+public:
+  /// Progress slices not taken by then are dropped, oldest first, so a JS side
+  /// that never takes them (no listener, reload) cannot grow the store
+  /// unbounded.
+  static constexpr size_t kMaxBuffers = 256;
+  /// Results have their own, separate limit: their promise takes them right
+  /// away, so only results a reloaded JS side will never take reach it.
+  static constexpr size_t kMaxResults = 64;
+
+  static WaveformBufferStore &shared();
+
+  /// Stores `values` and returns its id, always positive and below 2^53 so
+  /// it survives the trip through a JS number. `isResult` marks the values a
+  /// promise resolves with, which do not count against kMaxBuffers.
+  int64_t put(std::vector<float> values, bool isResult = false);
+
+  /// Removes and returns the buffer of `id`, or null if it was taken or dropped.
+  std::shared_ptr<std::vector<float>> take(int64_t id);
+
+private:
+  struct Entry {
+    std::shared_ptr<std::vector<float>> values;
+    bool isResult;
+  };
+
+  /// Ids of one kind of buffer in put order, taken ones included until they age out
+  struct Queue {
+    std::deque<int64_t> order;
+    /// Buffers of this kind still in buffers_
+    size_t count = 0;
+  };
+
+  void evict(Queue &queue, size_t limit);
+
+  std::mutex mutex_;
+  int64_t nextId_ = 1;
+  std::unordered_map<int64_t, Entry> buffers_;
+  Queue progress_;
+  Queue results_;
+};
+
+} // namespace audiowaveform
@@ -0,0 +1,68 @@
+//
+//  WaveformJsi.cpp
+//  AudioWaveform
+//
+
+#include "WaveformJsi.h"
+#include "LevelHistory.h"
+#include "WaveformBufferStore.h"
+
+#include <jsi/jsi.h>
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace audiowaveform {
+
+namespace jsi = facebook::jsi;
+
+namespace {
+
+/// Lets an ArrayBuffer own a stored buffer, so JS reads the floats in place.
+class FloatBuffer : public jsi::MutableBuffer {
+public:
+  explicit FloatBuffer(std::shared_ptr<std::vector<float>> values) : values_(std::move(values)) {}
+
+  size_t size() const override { return values_->size() * sizeof(float); }
+  uint8_t *data() override { return reinterpret_cast<uint8_t *>(values_->data()); }
+
+private:
+  std::shared_ptr<std::vector<float>> values_;
+};
+
+} // namespace
+
+void installJsiBindings(jsi::Runtime &runtime) {
+  auto takeBuffer = jsi::Function::createFromHostFunction(
+      runtime, jsi::PropNameID::forAscii(runtime, "takeBuffer"), 1,
+      [](jsi::Runtime &rt, const jsi::Value &, const jsi::Value *args, size_t count) -> jsi::Value {
+        if (count < 1 || !args[0].isNumber()) return jsi::Value::undefined();
+        auto values = WaveformBufferStore::shared().take(static_cast<int64_t>(args[0].asNumber()));
+        if (values == nullptr) return jsi::Value::undefined();
+        return jsi::ArrayBuffer(rt, std::make_shared<FloatBuffer>(std::move(values)));
+      });
+
+  auto recordingLevels = jsi::Function::createFromHostFunction(
+      runtime, jsi::PropNameID::forAscii(runtime, "recordingLevels"), 1,
+      [](jsi::Runtime &rt, const jsi::Value &, const jsi::Value *args, size_t count) -> jsi::Value {
+        const double requested = count < 1 || !args[0].isNumber() ? 0.0 : args[0].asNumber();
+        auto levels = std::make_shared<std::vector<float>>(
+            LevelHistory::recording().tail(requested > 0 ? static_cast<size_t>(requested) : 0));
+        return jsi::ArrayBuffer(rt, std::make_shared<FloatBuffer>(std::move(levels)));
+      });
+
+  auto recordingLevelCount = jsi::Function::createFromHostFunction(
+      runtime, jsi::PropNameID::forAscii(runtime, "recordingLevelCount"), 0,
+      [](jsi::Runtime &, const jsi::Value &, const jsi::Value *, size_t) -> jsi::Value {
+        return jsi::Value(static_cast<double>(LevelHistory::recording().total()));
+      });
+
+  jsi::Object bindings(runtime);
+  bindings.setProperty(runtime, "takeBuffer", std::move(takeBuffer));
+  bindings.setProperty(runtime, "recordingLevels", std::move(recordingLevels));
+  bindings.setProperty(runtime, "recordingLevelCount", std::move(recordingLevelCount));
+  runtime.global().setProperty(runtime, "__AudioWaveformJsi", std::move(bindings));
+}
+
+} // namespace audiowaveform
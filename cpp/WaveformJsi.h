@@ -0,0 +1,27 @@
+//
+//  WaveformJsi.h
+//  AudioWaveform
+//
+//  JSI bindings of the shared core. Installed on the JS thread from the
+//  platform modules' synchronous installJSIBindings method.
+//
+
+#pragma once
+
+namespace facebook {
+namespace jsi {
+class Runtime;
+} // namespace jsi
+} // namespace facebook
+
+namespace audiowaveform {
+
+/// Defines `global.__AudioWaveformJsi` with:
+/// - `takeBuffer(id: number): ArrayBuffer | undefined`, taking a buffer from
+///   WaveformBufferStore as an ArrayBuffer over the native floats (no copy).
+/// - `recordingLevels(count: number): ArrayBuffer`, the newest `count` levels
+///   of the recording history (LevelHistory.h), oldest first.
+/// - `recordingLevelCount(): number`, the number of levels recorded so far.
+void installJsiBindings(facebook::jsi::Runtime &runtime);
+
+} // namespace audiowaveform
@@ -0,0 +1,530 @@
+//
+//  WaveformReducer.cpp
+//  AudioWaveform
+//
+
+#include "WaveformReducer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define AW_NEON 1
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define AW_SSE2 1
+#endif
+
+namespace audiowaveform {
+
+namespace {
+
+inline float toFloat(uint8_t sample) { return (static_cast<int>(sample) - 128) / 128.0f; }
+inline float toFloat(int16_t sample) { return sample / 32768.0f; }
+inline float toFloat(float sample) { return sample; }
+
+template <typename T>
+void accumulate(const T *samples, size_t count, double &sumOfSquares, float &peak) {
+  double sum = 0.0;
+  float localPeak = peak;
+  for (size_t i = 0; i < count; ++i) {
+    const float value = toFloat(samples[i]);
+    sum += static_cast<double>(value) * value;
+    localPeak = std::max(localPeak, std::fabs(value));
+  }
+  sumOfSquares += sum;
+  peak = localPeak;
+}
+
+// Float lanes are flushed into the double accumulator every this many
+// samples so long buckets do not lose precision.
+constexpr size_t kFloatFlushInterval = 4096;
+
+/// Sum of squares and min/max of 16-bit PCM in a single pass. Squares are
+/// accumulated as integers, so the result matches the scalar path exactly.
+void accumulateInt16(const int16_t *samples, size_t count, double &sumOfSquares, float &peak) {
+  size_t i = 0;
+  int64_t sum = 0;
+  int16_t maxValue = 0;
+  int16_t minValue = 0;
+#if AW_NEON
+  int64x2_t sumLanes = vdupq_n_s64(0);
+  int16x8_t maxLanes = vdupq_n_s16(0);
+  int16x8_t minLanes = vdupq_n_s16(0);
+  for (; i + 8 <= count; i += 8) {
+    const int16x8_t v = vld1q_s16(samples + i);
+    const int16x4_t low = vget_low_s16(v);
+    const int16x4_t high = vget_high_s16(v);
+    sumLanes = vpadalq_s32(sumLanes, vmull_s16(low, low));
+    sumLanes = vpadalq_s32(sumLanes, vmull_s16(high, high));
+    maxLanes = vmaxq_s16(maxLanes, v);
+    minLanes = vminq_s16(minLanes, v);
+  }
+  sum = vgetq_lane_s64(sumLanes, 0) + vgetq_lane_s64(sumLanes, 1);
+  int16_t maxBuffer[8];
+  int16_t minBuffer[8];
+  vst1q_s16(maxBuffer, maxLanes);
+  vst1q_s16(minBuffer, minLanes);
+  for (int lane = 0; lane < 8; ++lane) {
+    maxValue = std::max(maxValue, maxBuffer[lane]);
+    minValue = std::min(minValue, minBuffer[lane]);
+  }
+#elif AW_SSE2
+  const __m128i zero = _mm_setzero_si128();
+  __m128i sumLanes = _mm_setzero_si128();
+  __m128i maxLanes = _mm_setzero_si128();
+  __m128i minLanes = _mm_setzero_si128();
+  for (; i + 8 <= count; i += 8) {
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(samples + i));
+    // Pairwise sums of squares are at most 2^31, so treat them as unsigned
+    // and widen to 64-bit lanes before accumulating.
+    const __m128i squares = _mm_madd_epi16(v, v);
+    sumLanes = _mm_add_epi64(sumLanes, _mm_unpacklo_epi32(squares, zero));
+    sumLanes = _mm_add_epi64(sumLanes, _mm_unpackhi_epi32(squares, zero));
+    maxLanes = _mm_max_epi16(maxLanes, v);
+    minLanes = _mm_min_epi16(minLanes, v);
+  }
+  int64_t sumBuffer[2];
+  int16_t maxBuffer[8];
+  int16_t minBuffer[8];
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(sumBuffer), sumLanes);
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(maxBuffer), maxLanes);
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(minBuffer), minLanes);
+  sum = sumBuffer[0] + sumBuffer[1];
+  for (int lane = 0; lane < 8; ++lane) {
+    maxValue = std::max(maxValue, maxBuffer[lane]);
+    minValue = std::min(minValue, minBuffer[lane]);
+  }
+#endif
+  for (; i < count; ++i) {
+    const int32_t value = samples[i];
+    sum += value * value;
+    maxValue = std::max<int16_t>(maxValue, samples[i]);
+    minValue = std::min<int16_t>(minValue, samples[i]);
+  }
+  constexpr double kScale = 1.0 / (32768.0 * 32768.0);
+  sumOfSquares += static_cast<double>(sum) * kScale;
+  const float localPeak = std::max(std::fabs(toFloat(maxValue)), std::fabs(toFloat(minValue)));
+  peak = std::max(peak, localPeak);
+}
+
+/// Sum of squares and min/max of float PCM in a single pass.
+void accumulateFloat32(const float *samples, size_t count, double &sumOfSquares, float &peak) {
+  size_t i = 0;
+  float maxValue = 0.0f;
+  float minValue = 0.0f;
+#if AW_NEON
+  float32x4_t maxLanes = vdupq_n_f32(0.0f);
+  float32x4_t minLanes = vdupq_n_f32(0.0f);
+  while (i + 4 <= count) {
+    const size_t blockEnd = std::min(count, i + kFloatFlushInterval);
+    float32x4_t sumLanes = vdupq_n_f32(0.0f);
+    for (; i + 4 <= blockEnd; i += 4) {
+      const float32x4_t v = vld1q_f32(samples + i);
+      sumLanes = vmlaq_f32(sumLanes, v, v);
+      maxLanes = vmaxq_f32(maxLanes, v);
+      minLanes = vminq_f32(minLanes, v);
+    }
+    float sumBuffer[4];
+    vst1q_f32(sumBuffer, sumLanes);
+    sumOfSquares += static_cast<double>(sumBuffer[0]) + sumBuffer[1] + sumBuffer[2] + sumBuffer[3];
+  }
+  float maxBuffer[4];
+  float minBuffer[4];
+  vst1q_f32(maxBuffer, maxLanes);
+  vst1q_f32(minBuffer, minLanes);
+  for (int lane = 0; lane < 4; ++lane) {
+    maxValue = std::max(maxValue, maxBuffer[lane]);
+    minValue = std::min(minValue, minBuffer[lane]);
+  }
+#elif AW_SSE2
+  __m128 maxLanes = _mm_setzero_ps();
+  __m128 minLanes = _mm_setzero_ps();
+  while (i + 4 <= count) {
+    const size_t blockEnd = std::min(count, i + kFloatFlushInterval);
+    __m128 sumLanes = _mm_setzero_ps();
+    for (; i + 4 <= blockEnd; i += 4) {
+      const __m128 v = _mm_loadu_ps(samples + i);
+      sumLanes = _mm_add_ps(sumLanes, _mm_mul_ps(v, v));
+      maxLanes = _mm_max_ps(maxLanes, v);
+      minLanes = _mm_min_ps(minLanes, v);
+    }
+    float sumBuffer[4];
+    _mm_storeu_ps(sumBuffer, sumLanes);
+    sumOfSquares += static_cast<double>(sumBuffer[0]) + sumBuffer[1] + sumBuffer[2] + sumBuffer[3];
+  }
+  float maxBuffer[4];
+  float minBuffer[4];
+  _mm_storeu_ps(maxBuffer, maxLanes);
+  _mm_storeu_ps(minBuffer, minLanes);
+  for (int lane = 0; lane < 4; ++lane) {
+    maxValue = std::max(maxValue, maxBuffer[lane]);
+    minValue = std::min(minValue, minBuffer[lane]);
+  }
+#endif
+  double tail = 0.0;
+  for (; i < count; ++i) {
+    tail += static_cast<double>(samples[i]) * samples[i];
+    maxValue = std::max(maxValue, samples[i]);
+    minValue = std::min(minValue, samples[i]);
+  }
+  sumOfSquares += tail;
+  peak = std::max(peak, std::max(std::fabs(maxValue), std::fabs(minValue)));
+}
+
+void accumulate(const void *data, size_t count, SampleFormat format, double &sumOfSquares, float &peak) {
+  switch (format) {
+    case SampleFormat::UInt8:
+      accumulate(static_cast<const uint8_t *>(data), count, sumOfSquares, peak);
+      break;
+    case SampleFormat::Int16:
+      accumulateInt16(static_cast<const int16_t *>(data), count, sumOfSquares, peak);
+      break;
+    case SampleFormat::Float32:
+      accumulateFloat32(static_cast<const float *>(data), count, sumOfSquares, peak);
+      break;
+  }
+}
+
+/// Per channel sums of squares and peaks of interleaved PCM, in a single pass
+/// over the frames.
+template <typename T>
+void accumulateChannels(const T *samples, size_t frameCount, int channels, double *sumsOfSquares,
+                        float *peaks) {
+  for (size_t frame = 0; frame < frameCount; ++frame) {
+    const T *values = samples + frame * channels;
+    for (int channel = 0; channel < channels; ++channel) {
+      const float value = toFloat(values[channel]);
+      sumsOfSquares[channel] += static_cast<double>(value) * value;
+      peaks[channel] = std::max(peaks[channel], std::fabs(value));
+    }
+  }
+}
+
+// Lanes of the per channel kernels: lane k accumulates every sample k, k + 8,
+// k + 16 and so on, so with a channel count that divides the lane count every
+// lane holds a single channel of the interleaved frames.
+constexpr int kInt16Lanes = 8;
+constexpr int kFloatLanes = 4;
+
+/// Per lane sums of squares and min/max of 16-bit PCM, as integers like
+/// accumulateInt16. Returns the samples consumed, a multiple of kInt16Lanes.
+size_t accumulateInt16Lanes(const int16_t *samples, size_t count, int64_t *sums, int16_t *maxValues,
+                            int16_t *minValues) {
+  size_t i = 0;
+#if AW_NEON
+  int64x2_t sumLanes[4] = {vdupq_n_s64(0), vdupq_n_s64(0), vdupq_n_s64(0), vdupq_n_s64(0)};
+  int16x8_t maxLanes = vdupq_n_s16(0);
+  int16x8_t minLanes = vdupq_n_s16(0);
+  for (; i + kInt16Lanes <= count; i += kInt16Lanes) {
+    const int16x8_t v = vld1q_s16(samples + i);
+    const int32x4_t low = vmull_s16(vget_low_s16(v), vget_low_s16(v));
+    const int32x4_t high = vmull_s16(vget_high_s16(v), vget_high_s16(v));
+    // Widened lane by lane, a pairwise add would mix neighbouring channels
+    sumLanes[0] = vaddw_s32(sumLanes[0], vget_low_s32(low));
+    sumLanes[1] = vaddw_s32(sumLanes[1], vget_high_s32(low));
+    sumLanes[2] = vaddw_s32(sumLanes[2], vget_low_s32(high));
+    sumLanes[3] = vaddw_s32(sumLanes[3], vget_high_s32(high));
+    maxLanes = vmaxq_s16(maxLanes, v);
+    minLanes = vminq_s16(minLanes, v);
+  }
+  for (int pair = 0; pair < 4; ++pair) vst1q_s64(sums + pair * 2, sumLanes[pair]);
+  vst1q_s16(maxValues, maxLanes);
+  vst1q_s16(minValues, minLanes);
+#elif AW_SSE2
+  const __m128i zero = _mm_setzero_si128();
+  __m128i sumLanes[4] = {zero, zero, zero, zero};
+  __m128i maxLanes = zero;
+  __m128i minLanes = zero;
+  for (; i + kInt16Lanes <= count; i += kInt16Lanes) {
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(samples + i));
+    // Squares are at most 2^30, the 32-bit products of each lane stay positive
+    const __m128i low = _mm_mullo_epi16(v, v);
+    const __m128i high = _mm_mulhi_epi16(v, v);
+    const __m128i squaresLow = _mm_unpacklo_epi16(low, high);
+    const __m128i squaresHigh = _mm_unpackhi_epi16(low, high);
+    sumLanes[0] = _mm_add_epi64(sumLanes[0], _mm_unpacklo_epi32(squaresLow, zero));
+    sumLanes[1] = _mm_add_epi64(sumLanes[1], _mm_unpackhi_epi32(squaresLow, zero));
+    sumLanes[2] = _mm_add_epi64(sumLanes[2], _mm_unpacklo_epi32(squaresHigh, zero));
+    sumLanes[3] = _mm_add_epi64(sumLanes[3], _mm_unpackhi_epi32(squaresHigh, zero));
+    maxLanes = _mm_max_epi16(maxLanes, v);
+    minLanes = _mm_min_epi16(minLanes, v);
+  }
+  for (int pair = 0; pair < 4; ++pair) {
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(sums + pair * 2), sumLanes[pair]);
+  }
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(maxValues), maxLanes);
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(minValues), minLanes);
+#else
+  (void)samples;
+  (void)count;
+  (void)sums;
+  (void)maxValues;
+  (void)minValues;
+#endif
+  return i;
+}
+
+/// Per lane sums of squares and min/max of float PCM, flushed to double like
+/// accumulateFloat32. Returns the samples consumed, a multiple of kFloatLanes.
+size_t accumulateFloat32Lanes(const float *samples, size_t count, double *sums, float *maxValues,
+                              float *minValues) {
+  size_t i = 0;
+  float sumBuffer[kFloatLanes];
+#if AW_NEON
+  float32x4_t maxLanes = vdupq_n_f32(0.0f);
+  float32x4_t minLanes = vdupq_n_f32(0.0f);
+  while (i + kFloatLanes <= count) {
+    const size_t blockEnd = std::min(count, i + kFloatFlushInterval);
+    float32x4_t sumLanes = vdupq_n_f32(0.0f);
+    for (; i + kFloatLanes <= blockEnd; i += kFloatLanes) {
+      const float32x4_t v = vld1q_f32(samples + i);
+      sumLanes = vmlaq_f32(sumLanes, v, v);
+      maxLanes = vmaxq_f32(maxLanes, v);
+      minLanes = vminq_f32(minLanes, v);
+    }
+    vst1q_f32(sumBuffer, sumLanes);
+    for (int lane = 0; lane < kFloatLanes; ++lane) sums[lane] += sumBuffer[lane];
+  }
+  vst1q_f32(maxValues, maxLanes);
+  vst1q_f32(minValues, minLanes);
+#elif AW_SSE2
+  __m128 maxLanes = _mm_setzero_ps();
+  __m128 minLanes = _mm_setzero_ps();
+  while (i + kFloatLanes <= count) {
+    const size_t blockEnd = std::min(count, i + kFloatFlushInterval);
+    __m128 sumLanes = _mm_setzero_ps();
+    for (; i + kFloatLanes <= blockEnd; i += kFloatLanes) {
+      const __m128 v = _mm_loadu_ps(samples + i);
+      sumLanes = _mm_add_ps(sumLanes, _mm_mul_ps(v, v));
+      maxLanes = _mm_max_ps(maxLanes, v);
+      minLanes = _mm_min_ps(minLanes, v);
+    }
+    _mm_storeu_ps(sumBuffer, sumLanes);
+    for (int lane = 0; lane < kFloatLanes; ++lane) sums[lane] += sumBuffer[lane];
+  }
+  _mm_storeu_ps(maxValues, maxLanes);
+  _mm_storeu_ps(minValues, minLanes);
+#else
+  (void)samples;
+  (void)count;
+  (void)sums;
+  (void)maxValues;
+  (void)minValues;
+  (void)sumBuffer;
+#endif
+  return i;
+}
+
+/// accumulateChannels of 16-bit PCM, vectorized for 1, 2, 4 or 8 channels.
+void accumulateChannelsInt16(const int16_t *samples, size_t frameCount, int channels, double *sumsOfSquares,
+                             float *peaks) {
+  size_t consumed = 0;
+  if (kInt16Lanes % channels == 0) {
+    int64_t sums[kInt16Lanes] = {};
+    int16_t maxValues[kInt16Lanes] = {};
+    int16_t minValues[kInt16Lanes] = {};
+    consumed = accumulateInt16Lanes(samples, frameCount * static_cast<size_t>(channels), sums, maxValues, minValues);
+    constexpr double kScale = 1.0 / (32768.0 * 32768.0);
+    for (int lane = 0; lane < kInt16Lanes; ++lane) {
+      const int channel = lane % channels;
+      sumsOfSquares[channel] += static_cast<double>(sums[lane]) * kScale;
+      peaks[channel] = std::max(peaks[channel], std::max(std::fabs(toFloat(maxValues[lane])),
+                                                         std::fabs(toFloat(minValues[lane]))));
+    }
+  }
+  // Consumed samples are whole frames, the lane count is a multiple of the channels
+  accumulateChannels(samples + consumed, frameCount - consumed / static_cast<size_t>(channels), channels,
+                     sumsOfSquares, peaks);
+}
+
+/// accumulateChannels of float PCM, vectorized for 1, 2 or 4 channels.
+void accumulateChannelsFloat32(const float *samples, size_t frameCount, int channels, double *sumsOfSquares,
+                               float *peaks) {
+  size_t consumed = 0;
+  if (kFloatLanes % channels == 0) {
+    double sums[kFloatLanes] = {};
+    float maxValues[kFloatLanes] = {};
+    float minValues[kFloatLanes] = {};
+    consumed = accumulateFloat32Lanes(samples, frameCount * static_cast<size_t>(channels), sums, maxValues, minValues);
+    for (int lane = 0; lane < kFloatLanes; ++lane) {
+      const int channel = lane % channels;
+      sumsOfSquares[channel] += sums[lane];
+      peaks[channel] = std::max(peaks[channel], std::max(std::fabs(maxValues[lane]), std::fabs(minValues[lane])));
+    }
+  }
+  accumulateChannels(samples + consumed, frameCount - consumed / static_cast<size_t>(channels), channels,
+                     sumsOfSquares, peaks);
+}
+
+void accumulateChannels(const void *data, size_t frameCount, int channels, SampleFormat format,
+                        double *sumsOfSquares, float *peaks) {
+  switch (format) {
+    case SampleFormat::UInt8:
+      accumulateChannels(static_cast<const uint8_t *>(data), frameCount, channels, sumsOfSquares, peaks);
+      break;
+    case SampleFormat::Int16:
+      accumulateChannelsInt16(static_cast<const int16_t *>(data), frameCount, channels, sumsOfSquares, peaks);
+      break;
+    case SampleFormat::Float32:
+      accumulateChannelsFloat32(static_cast<const float *>(data), frameCount, channels, sumsOfSquares, peaks);
+      break;
+  }
+}
+
+} // namespace
+
+size_t bytesPerSample(SampleFormat format) {
+  switch (format) {
+    case SampleFormat::UInt8:
+      return 1;
+    case SampleFormat::Int16:
+      return 2;
+    case SampleFormat::Float32:
+      return 4;
+  }
+  return 2;
+}
+
+WaveformReducer::WaveformReducer(int channels, int64_t framesPerBucket, ChannelMode mode)
+    : channels_(std::max(1, channels)), framesPerBucket_(std::max<int64_t>(1, framesPerBucket)), mode_(mode) {
+  if (separatesChannels()) {
+    channelSumsOfSquares_.assign(static_cast<size_t>(channels_), 0.0);
+    channelPeaks_.assign(static_cast<size_t>(channels_), 0.0f);
+  }
+}
+
+size_t WaveformReducer::process(const void *data, size_t byteCount, SampleFormat format,
+                                float *rmsOut, float *peakOut, size_t capacity) {
+  const size_t sampleSize = bytesPerSample(format);
+  const size_t frameSize = sampleSize * channels_;
+  size_t framesLeft = byteCount / frameSize;
+  const uint8_t *cursor = static_cast<const uint8_t *>(data);
+  size_t written = 0;
+
+  while (framesLeft > 0) {
+    const size_t span = static_cast<size_t>(
+        std::min<int64_t>(static_cast<int64_t>(framesLeft), framesPerBucket_ - framesInBucket_));
+    // Frames that do not complete a bucket are still accumulated, only a full
+    // output stops the buffer
+    if (written == capacity && framesInBucket_ + static_cast<int64_t>(span) == framesPerBucket_) break;
+    if (separatesChannels()) {
+      accumulateChannels(cursor, span, channels_, format, channelSumsOfSquares_.data(), channelPeaks_.data());
+    } else {
+      accumulate(cursor, span * channels_, format, sumOfSquares_, peak_);
+    }
+    cursor += span * frameSize;
+    framesLeft -= span;
+    framesInBucket_ += span;
+
+    if (framesInBucket_ == framesPerBucket_) {
+      emit(rmsOut, peakOut, written++);
+    }
+  }
+  return written;
+}
+
+size_t WaveformReducer::processPlanar(const float *const *channels, size_t frameCount, float *rmsOut,
+                                      float *peakOut, size_t capacity) {
+  size_t offset = 0;
+  size_t written = 0;
+
+  while (offset < frameCount) {
+    const size_t span = static_cast<size_t>(
+        std::min<int64_t>(static_cast<int64_t>(frameCount - offset), framesPerBucket_ - framesInBucket_));
+    if (written == capacity && framesInBucket_ + static_cast<int64_t>(span) == framesPerBucket_) break;
+    for (int channel = 0; channel < channels_; ++channel) {
+      // Planar channels are contiguous, so each gets the vectorized kernel
+      if (separatesChannels()) {
+        accumulateFloat32(channels[channel] + offset, span, channelSumsOfSquares_[channel], channelPeaks_[channel]);
+      } else {
+        accumulateFloat32(channels[channel] + offset, span, sumOfSquares_, peak_);
+      }
+    }
+    offset += span;
+    framesInBucket_ += span;
+
+    if (framesInBucket_ == framesPerBucket_) {
+      emit(rmsOut, peakOut, written++);
+    }
+  }
+  return written;
+}
+
+size_t WaveformReducer::flush(float *rmsOut, float *peakOut) {
+  if (framesInBucket_ == 0) return 0;
+  emit(rmsOut, peakOut, 0);
+  return 1;
+}
+
+size_t WaveformReducer::maxBucketsFor(size_t byteCount, SampleFormat format) const {
+  const int64_t frames = static_cast<int64_t>(byteCount / (bytesPerSample(format) * channels_));
+  return static_cast<size_t>((framesInBucket_ + frames) / framesPerBucket_);
+}
+
+void WaveformReducer::reset() {
+  framesInBucket_ = 0;
+  sumOfSquares_ = 0.0;
+  peak_ = 0.0f;
+  std::fill(channelSumsOfSquares_.begin(), channelSumsOfSquares_.end(), 0.0);
+  std::fill(channelPeaks_.begin(), channelPeaks_.end(), 0.0f);
+}
+
+void WaveformReducer::emit(float *rmsOut, float *peakOut, size_t index) {
+  const double frames = static_cast<double>(framesInBucket_);
+  if (!separatesChannels()) {
+    rmsOut[index] = static_cast<float>(std::sqrt(sumOfSquares_ / (frames * channels_)));
+    if (peakOut != nullptr) peakOut[index] = peak_;
+  } else if (mode_ == ChannelMode::Max) {
+    float rms = 0.0f;
+    float peak = 0.0f;
+    for (int channel = 0; channel < channels_; ++channel) {
+      rms = std::max(rms, static_cast<float>(std::sqrt(channelSumsOfSquares_[channel] / frames)));
+      peak = std::max(peak, channelPeaks_[channel]);
+    }
+    rmsOut[index] = rms;
+    if (peakOut != nullptr) peakOut[index] = peak;
+  } else {
+    const size_t first = index * static_cast<size_t>(channels_);
+    for (int channel = 0; channel < channels_; ++channel) {
+      rmsOut[first + channel] = static_cast<float>(std::sqrt(channelSumsOfSquares_[channel] / frames));
+      if (peakOut != nullptr) peakOut[first + channel] = channelPeaks_[channel];
+    }
+  }
+  reset();
+}
+
+void reduceBlock(const void *data, size_t frameCount, int channels, SampleFormat format,
+                 float *rmsOut, float *peakOut) {
+  const size_t count = frameCount * std::max(1, channels);
+  double sumOfSquares = 0.0;
+  float peak = 0.0f;
+  accumulate(data, count, format, sumOfSquares, peak);
+  *rmsOut = count > 0 ? static_cast<float>(std::sqrt(sumOfSquares / static_cast<double>(count))) : 0.0f;
+  if (peakOut != nullptr) *peakOut = peak;
+}
+
+float normalizationMax(const float *values, size_t count, float threshold) {
+  bool found = false;
+  float maxValue = 0.0f;
+  for (size_t i = 0; i < count; ++i) {
+    if (std::fabs(values[i]) < threshold) continue;
+    maxValue = found ? std::max(maxValue, values[i]) : values[i];
+    found = true;
+  }
+  return found ? maxValue : 1.0f;
+}
+
+void normalize(float *values, size_t count, float maxValue, float scale, float threshold) {
+  if (!(maxValue > 0.0f)) return;
+  const float factor = scale / maxValue;
+  // Branch free, so the loop vectorizes
+  for (size_t i = 0; i < count; ++i) {
+    const float value = values[i];
+    values[i] = std::fabs(value) < threshold ? 0.0f : value * factor;
+  }
+}
+
+} // namespace audiowaveform
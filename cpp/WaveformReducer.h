@@ -0,0 +1,106 @@
+//
+//  WaveformReducer.h
+//  AudioWaveform
+//
+//  Portable peak/RMS reduction kernel shared by the Android (JNI) and iOS
+//  (bridging header) waveform extractors.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace audiowaveform {
+
+/// Raw values match the PCM bit depth reported by the platform decoders.
+/// 8-bit PCM is unsigned offset-binary, as delivered by MediaCodec.
+enum class SampleFormat : int {
+  UInt8 = 8,
+  Int16 = 16,
+  Float32 = 32,
+};
+
+/// Size in bytes of a single sample of the given format.
+size_t bytesPerSample(SampleFormat format);
+
+/// How the channels of a frame end up in the buckets.
+enum class ChannelMode : int {
+  /// One value per bucket, over the samples of all channels.
+  Mixdown = 0,
+  /// One value per bucket, of the loudest channel.
+  Max = 1,
+  /// One value per channel and bucket, all channels of a bucket in a row.
+  PerChannel = 2,
+};
+
+/// Reduces interleaved PCM into fixed-size buckets of RMS and peak values.
+///
+/// The reducer keeps its accumulator between calls, so a bucket may span any
+/// number of decoder output buffers. Completed buckets are written into the
+/// caller-owned output arrays; nothing is allocated while reducing. Every
+/// bucket takes `valuesPerBucket()` entries of the outputs.
+class WaveformReducer {
+public:
+  WaveformReducer(int channels, int64_t framesPerBucket, ChannelMode mode = ChannelMode::Mixdown);
+
+  /// Feeds `byteCount` bytes of interleaved PCM. Writes at most `capacity`
+  /// completed buckets to `rmsOut` (and to `peakOut` when it is not null) and
+  /// returns how many were written. Frames after the last completed bucket
+  /// carry over into the next call; only those that would complete a bucket
+  /// past `capacity` are discarded. See `maxBucketsFor` to size the outputs.
+  size_t process(const void *data, size_t byteCount, SampleFormat format,
+                 float *rmsOut, float *peakOut, size_t capacity);
+
+  /// Same as `process` for `frameCount` frames of planar float PCM, one
+  /// pointer per channel, as AVAudioPCMBuffer delivers it.
+  size_t processPlanar(const float *const *channels, size_t frameCount,
+                       float *rmsOut, float *peakOut, size_t capacity);
+
+  /// Emits the partially filled bucket, if any. Returns 0 or 1.
+  size_t flush(float *rmsOut, float *peakOut);
+
+  /// Number of buckets `process` can complete for a buffer of `byteCount`.
+  size_t maxBucketsFor(size_t byteCount, SampleFormat format) const;
+
+  void reset();
+
+  int channels() const { return channels_; }
+  int64_t framesPerBucket() const { return framesPerBucket_; }
+  /// Frames in the partially filled bucket that `flush` would emit.
+  int64_t framesInBucket() const { return framesInBucket_; }
+  ChannelMode channelMode() const { return mode_; }
+  size_t valuesPerBucket() const {
+    return mode_ == ChannelMode::PerChannel ? static_cast<size_t>(channels_) : 1;
+  }
+
+private:
+  /// Whether channels are accumulated apart; a single channel never is.
+  bool separatesChannels() const { return mode_ != ChannelMode::Mixdown && channels_ > 1; }
+  void emit(float *rmsOut, float *peakOut, size_t index);
+
+  int channels_;
+  int64_t framesPerBucket_;
+  ChannelMode mode_;
+  int64_t framesInBucket_ = 0;
+  double sumOfSquares_ = 0.0;
+  float peak_ = 0.0f;
+  // Per channel accumulators when separatesChannels(), sized once up front
+  std::vector<double> channelSumsOfSquares_;
+  std::vector<float> channelPeaks_;
+};
+
+/// One-shot reduction of a whole block into a single RMS/peak pair.
+void reduceBlock(const void *data, size_t frameCount, int channels,
+                 SampleFormat format, float *rmsOut, float *peakOut);
+
+/// Largest of `values` at or above `threshold`, the value `normalize` scales
+/// to. 1 if there is none, which leaves every value to be zeroed.
+float normalizationMax(const float *values, size_t count, float threshold);
+
+/// Scales `values` in place so that `maxValue` becomes `scale`. Values below
+/// `threshold` become 0. Does nothing unless `maxValue` is positive.
+void normalize(float *values, size_t count, float maxValue, float scale, float threshold);
+
+} // namespace audiowaveform
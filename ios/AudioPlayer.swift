@@ -12,14 +12,18 @@ class AudioPlayer: NSObject, AVAudioPlayerDelegate {
   
   private var seekToStart = true
   private var stopWhenCompleted = false
-  private var timer: Timer?
   private var player: AVAudioPlayer?
+  /// Path the player was taken from the pool for
+  private var playerPath: String?
   private var finishMode: FinishMode = FinishMode.stop
     private var updateFrequency = UpdateFrequency.medium
+    private var interpolatePosition = false
   var plugin: AudioWaveform
   var playerKey: String
   var rnChannel: AnyObject
   private var isComponentMounted: Bool = true // Add flag to track mounted state
+  /// When the current prepare started, until the player first plays, for PerfStats
+  private var prepareStart: CFTimeInterval = 0
   
   init(plugin: AudioWaveform, playerKey: String, channel: AnyObject) {
     self.plugin = plugin
@@ -28,9 +32,10 @@ class AudioPlayer: NSObject, AVAudioPlayerDelegate {
     super.init()
   }
   
-  func preparePlayer(_ path: String?, volume: Double?, updateFrequency: UpdateFrequency, time: Double, resolver resolve: RCTPromiseResolveBlock, rejecter reject: RCTPromiseRejectBlock) {
+  func preparePlayer(_ path: String?, volume: Double?, updateFrequency: UpdateFrequency, interpolatePosition: Bool, time: Double, resolver resolve: RCTPromiseResolveBlock, rejecter reject: RCTPromiseRejectBlock) {
     if(!(path ?? "").isEmpty) {
       self.updateFrequency = updateFrequency
+      self.interpolatePosition = interpolatePosition
       isComponentMounted = true
       let audioUrl = URL.init(string: path!)
       if(audioUrl == nil){
@@ -38,9 +43,13 @@ class AudioPlayer: NSObject, AVAudioPlayerDelegate {
         return
       }
      
+      prepareStart = CACurrentMediaTime()
       do {
-        player = try AVAudioPlayer(contentsOf: audioUrl!)
-        player?.prepareToPlay()
+        // Preparing again without a stop keeps the previous player out of the pool
+        releasePlayer()
+        // Already primed if the path was prefetched or played before
+        player = try plugin.playerPool.acquire(path!, url: audioUrl!)
+        playerPath = path
         player?.volume = Float(volume ?? 100.0)
         player?.currentTime = Double(time / 1000)
         player?.enableRate = true
@@ -69,11 +78,11 @@ class AudioPlayer: NSObject, AVAudioPlayerDelegate {
     case .pause:
       self.player?.pause()
       stopListening()
+      timerUpdate()
       finishType = FinishMode.pause.rawValue
     case .stop:
-      self.player?.stop()
       stopListening()
-      self.player = nil
+      releasePlayer()
       finishType = FinishMode.stop.rawValue
     }
     self.sendEvent(withName: Constants.onDidFinishPlayingAudio, body:  [Constants.finishType: finishType, Constants.playerKey: playerKey])
@@ -96,6 +105,11 @@ class AudioPlayer: NSObject, AVAudioPlayerDelegate {
         self.finishMode = FinishMode.stop
       }
       player?.play()
+      if prepareStart > 0 && player?.isPlaying == true {
+        let latency = PerfStats.elapsedMs(since: prepareStart)
+        PerfStats.shared.record(playerKey) { $0.prepareToFirstAudioMs = latency }
+        prepareStart = 0
+      }
       player?.delegate = self
       player?.rate = Float(speed)
       timerUpdate()
@@ -112,10 +126,18 @@ class AudioPlayer: NSObject, AVAudioPlayerDelegate {
   
   func stopPlayer() {
     stopListening()
-    player?.stop()
+    player?.pause()
     timerUpdate()
+    releasePlayer()
+  }
+
+  /// Hands the player back to the pool, primed for its path
+  private func releasePlayer() {
+    if let player = player, let path = playerPath {
+      plugin.playerPool.recycle(path, player: player)
+    }
     player = nil
-    timer = nil
+    playerPath = nil
   }
   
   func getDuration(_ type: DurationType, _ result: @escaping RCTPromiseResolveBlock) {
@@ -136,6 +158,8 @@ class AudioPlayer: NSObject, AVAudioPlayerDelegate {
   func seekTo(_ time: Double?, _ result: @escaping RCTPromiseResolveBlock) {
     if(time != 0 && time != nil) {
       player?.currentTime = Double(time! / 1000)
+      // Extrapolating listeners would run from the old position until the next tick
+      timerUpdate()
       result(true)
     } else {
       result(false)
@@ -143,22 +167,35 @@ class AudioPlayer: NSObject, AVAudioPlayerDelegate {
   }
   
     @objc func timerUpdate() {
+        plugin.playbackTicker.emit(self)
+    }
+
+    /// The position entry of this player in onCurrentDurations, or nil while it is unmounted. It
+    /// carries the time it was read at and the rate, for listeners to extrapolate between ticks.
+    func positionSnapshot() -> [String: Any]? {
+        guard isComponentMounted else { return nil }
         let ms = (self.player?.currentTime ?? 0) * 1000
-        self.sendEvent(withName: Constants.onCurrentDuration, body: [ Constants.currentDuration: Int(ms), Constants.playerKey: self.playerKey] as [String : Any])
+        return [
+          Constants.currentDuration: Int(ms),
+          Constants.playerKey: self.playerKey,
+          Constants.timestamp: Date().timeIntervalSince1970 * 1000,
+          Constants.speed: Double(self.player?.rate ?? 1),
+          Constants.isPlaying: self.player?.isPlaying ?? false,
+        ]
     }
     
     func startListening() {
-      stopListening()
-        DispatchQueue.main.async { [weak self] in
-          guard let strongSelf = self else {return }
-            strongSelf.timer = Timer.scheduledTimer(timeInterval: TimeInterval((Float(strongSelf.updateFrequency.rawValue) / 1000)), target: strongSelf, selector: #selector(strongSelf.timerUpdate), userInfo: nil, repeats: true)
-        }
+      let interval = interpolatePosition
+        ? Constants.interpolatedUpdateInterval
+        : TimeInterval(updateFrequency.rawValue / 1000)
+      plugin.playbackTicker.register(self, interval: interval)
     }
     
     func setPlaybackSpeed(_ speed: Float) -> Bool {
         if let player = player {
             player.enableRate = true
             player.rate = Float(speed)
+            timerUpdate()
             return true
         } else {
             return false
@@ -166,7 +203,6 @@ class AudioPlayer: NSObject, AVAudioPlayerDelegate {
     }
   
   func stopListening() {
-    timer?.invalidate()
-    timer = nil
+    plugin.playbackTicker.unregister(playerKey: playerKey)
   }
 }
@@ -15,7 +15,11 @@ public class AudioRecorder: NSObject, AVAudioRecorderDelegate{
   var useLegacyNormalization: Bool = false
   var audioUrl: URL?
   var recordedDuration: CMTime = CMTime.zero
-  private var timer: Timer?
+  private var timer: RepeatingTimer?
+  /// Set instead of `audioRecorder` while recording with the engine tap
+  private var engineRecorder: EngineRecorder?
+  /// Values of the waveform the current engine recording resolves with when stopped, 0 for none
+  private var waveformSamples = 0
     var updateFrequency = UpdateFrequency.medium
   
   private func createAudioRecordPath(fileNameFormat: String?) -> URL? {
@@ -27,7 +31,7 @@ public class AudioRecorder: NSObject, AVAudioRecorderDelegate{
     return url
   }
   
-    func startRecording(_ path: String?, encoder : Int?, updateFrequency: UpdateFrequency, sampleRate : Int?, bitRate : Int?, fileNameFormat: String?, useLegacy: Bool?, resolver resolve: RCTPromiseResolveBlock, rejecter reject: RCTPromiseRejectBlock) -> Void {
+    func startRecording(_ path: String?, encoder : Int?, updateFrequency: UpdateFrequency, sampleRate : Int?, bitRate : Int?, fileNameFormat: String?, useLegacy: Bool?, engine: String? = nil, waveformSamples: Int? = nil, resolver resolve: RCTPromiseResolveBlock, rejecter reject: RCTPromiseRejectBlock) -> Void {
     useLegacyNormalization = useLegacy ?? false
       self.updateFrequency = updateFrequency
     let settings = [
@@ -65,10 +69,23 @@ public class AudioRecorder: NSObject, AVAudioRecorderDelegate{
         reject(Constants.audioWaveforms, "Failed to initialise file URL", nil)
         return
       }
+      if engine == Constants.pcmEngine {
+        let recorder = EngineRecorder(url: newPath, settings: settings as [String : Any], batchInterval: updateFrequency.rawValue / 1000, useLegacyNormalization: useLegacyNormalization) { levels in
+          // Called on the recorder's queue, one event per batch
+          EventEmitter.sharedInstance.dispatch(name: Constants.onCurrentRecordingWaveformData, body: [Constants.currentDecibel: levels.last ?? 0, Constants.levels: levels])
+        }
+        AWLevelHistoryClear()
+        try recorder.start()
+        engineRecorder = recorder
+        self.waveformSamples = max(0, waveformSamples ?? 0)
+        resolve(true)
+        return
+      }
       audioRecorder = try AVAudioRecorder(url: newPath, settings: settings as [String : Any])
       audioRecorder?.delegate = self
       audioRecorder?.isMeteringEnabled = true
       audioRecorder?.record()
+      AWLevelHistoryClear()
         startListening()
       resolve(true)
     } catch let error as NSError {
@@ -77,18 +94,19 @@ public class AudioRecorder: NSObject, AVAudioRecorderDelegate{
     }
   }
     
-    @objc func timerUpdate(_ sender:Timer) {
+    private func timerUpdate() {
         if (audioRecorder?.isRecording ?? false) {
-            EventEmitter.sharedInstance.dispatch(name: Constants.onCurrentRecordingWaveformData, body: [Constants.currentDecibel: getDecibelLevel()])
+            let level = getDecibelLevel()
+            AWLevelHistoryPush(level)
+            EventEmitter.sharedInstance.dispatch(name: Constants.onCurrentRecordingWaveformData, body: [Constants.currentDecibel: level])
         }
     }
     
     func startListening() {
       stopListening()
-        DispatchQueue.main.async { [weak self] in
-          guard let strongSelf = self else {return }
-            strongSelf.timer = Timer.scheduledTimer(timeInterval: TimeInterval((Float(strongSelf.updateFrequency.rawValue) / 1000)), target: strongSelf, selector: #selector(strongSelf.timerUpdate(_:)), userInfo: nil, repeats: true)
-        }
+      timer = RepeatingTimer(interval: TimeInterval(updateFrequency.rawValue / 1000)) { [weak self] in
+        self?.timerUpdate()
+      }
     }
   
   func stopListening() {
@@ -97,6 +115,25 @@ public class AudioRecorder: NSObject, AVAudioRecorderDelegate{
   }
   
   public func stopRecording(_ resolve: @escaping RCTPromiseResolveBlock, rejecter reject: @escaping RCTPromiseRejectBlock) -> Void {
+    if let recorder = engineRecorder {
+      engineRecorder = nil
+      let waveformSamples = self.waveformSamples
+      recorder.stop { duration in
+        guard duration >= 0 else {
+          reject(Constants.audioWaveforms, "Failed to stop recording: nothing was recorded", nil)
+          return
+        }
+        var result: [Any] = [recorder.url.absoluteString, duration.description]
+        // Served from the pyramid the recorder stored, normalized like extractWaveformData
+        if waveformSamples > 0, var waveform = PeakCache.shared.load(path: recorder.url.path, bucketCount: waveformSamples)?.rms {
+          let threshold = Constants.defaultNormalizationThreshold
+          AWNormalize(&waveform, waveform.count, AWNormalizationMax(waveform, waveform.count, threshold), Constants.defaultNormalizationScale, threshold)
+          result.append(waveform)
+        }
+        resolve(result)
+      }
+      return
+    }
       stopListening()
     audioRecorder?.stop()
     if(audioUrl != nil) {
@@ -122,16 +159,21 @@ public class AudioRecorder: NSObject, AVAudioRecorderDelegate{
   }
   
   public func pauseRecording(_ resolve: RCTPromiseResolveBlock) -> Void {
+    engineRecorder?.setPaused(true)
     audioRecorder?.pause()
     resolve(true)
   }
   
   public func resumeRecording(_ resolve: RCTPromiseResolveBlock) -> Void {
+    engineRecorder?.setPaused(false)
     audioRecorder?.record()
     resolve(true)
   }
     
     func getDecibelLevel() -> Float {
+        if let recorder = engineRecorder {
+          return recorder.level
+        }
         audioRecorder?.updateMeters()
         if(useLegacyNormalization){
           let amp = audioRecorder?.averagePower(forChannel: 0) ?? 0.0
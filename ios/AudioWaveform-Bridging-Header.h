@@ -10,4 +10,7 @@
 #import <React/RCTViewManager.h>
 #import <React/RCTViewManager.h>
 #import <React/RCTComponent.h>
-#import <React/RCTEventEmitter.h>
\ No newline at end of file
+#import <React/RCTEventEmitter.h>
+
+#import "AudioWaveformCore.h"
+#import "AudioWaveformJsiInstaller.h"
@@ -37,6 +37,10 @@ RCT_EXTERN_METHOD(extractWaveformData:(NSDictionary *)args
                   resolver: (RCTPromiseResolveBlock)resolve
                   rejecter: (RCTPromiseRejectBlock)reject)
 
+RCT_EXTERN_METHOD(extractWaveformDataBatch:(NSDictionary *)args
+                  resolver: (RCTPromiseResolveBlock)resolve
+                  rejecter: (RCTPromiseRejectBlock)reject)
+
 RCT_EXTERN_METHOD(preparePlayer:(NSDictionary *)args
                   resolver: (RCTPromiseResolveBlock)resolve
                   rejecter: (RCTPromiseRejectBlock)reject)
@@ -66,4 +70,25 @@ RCT_EXTERN_METHOD(setPlaybackSpeed:(NSDictionary *)args
 RCT_EXTERN_METHOD(markPlayerAsUnmounted)
 RCT_EXTERN_METHOD(stopAllWaveFormExtractors:(RCTPromiseResolveBlock)resolve
                   rejecter: (RCTPromiseRejectBlock)reject)
+RCT_EXTERN_METHOD(cancelWaveformExtraction:(NSDictionary *)args
+                  resolver: (RCTPromiseResolveBlock)resolve
+                  rejecter: (RCTPromiseRejectBlock)reject)
+RCT_EXTERN__BLOCKING_SYNCHRONOUS_METHOD(installJSIBindings)
+RCT_EXTERN_METHOD(prepareWithWaveform:(NSDictionary *)args
+                  resolver: (RCTPromiseResolveBlock)resolve
+                  rejecter: (RCTPromiseRejectBlock)reject)
+RCT_EXTERN_METHOD(prefetchPlayer:(NSDictionary *)args
+                  resolver: (RCTPromiseResolveBlock)resolve
+                  rejecter: (RCTPromiseRejectBlock)reject)
+RCT_EXTERN_METHOD(setMaxConcurrentExtractions:(NSDictionary *)args
+                  resolver: (RCTPromiseResolveBlock)resolve
+                  rejecter: (RCTPromiseRejectBlock)reject)
+
+RCT_EXTERN_METHOD(setPerfStatsEnabled:(NSDictionary *)args
+                  resolver: (RCTPromiseResolveBlock)resolve
+                  rejecter: (RCTPromiseRejectBlock)reject)
+
+RCT_EXTERN_METHOD(getPerfStats:(NSDictionary *)args
+                  resolver: (RCTPromiseResolveBlock)resolve
+                  rejecter: (RCTPromiseRejectBlock)reject)
 @end
@@ -5,13 +5,20 @@
 //  Created by Viraj Patel on 12/09/23.
 //
 
+import Accelerate
 import UIKit
 
 @objc(AudioWaveform)
 class AudioWaveform: RCTEventEmitter {
   final var audioRecorder = AudioRecorder()
   var audioPlayers = [String: AudioPlayer]()
-  var extractors = [String: WaveformExtractor]()
+  private let extractionScheduler = ExtractionScheduler()
+  /// Cache writes of finished extractions, after their promise resolved
+  private let cacheQueue = DispatchQueue(label: "AudioWaveformPeakCache", qos: .utility)
+  /// Shared by all players, see PlaybackTicker.swift
+  let playbackTicker = PlaybackTicker()
+  /// Prepared players of recently played or prefetched paths, see PlayerPool.swift
+  let playerPool = PlayerPool()
   
   override init() {
     super.init()
@@ -21,7 +28,6 @@ class AudioWaveform: RCTEventEmitter {
   
   deinit {
     audioPlayers.removeAll()
-    extractors.removeAll()
     NotificationCenter.default.removeObserver(self)
   }
   
@@ -34,7 +40,8 @@ class AudioWaveform: RCTEventEmitter {
   
     @objc
     override static func requiresMainQueueSetup() -> Bool {
-        return true
+        // Nothing in init touches UIKit, and extraction runs on ExtractionScheduler's queue
+        return false
     }
   // we need to override this method and
   // return an array of event names that we can listen to
@@ -78,6 +85,8 @@ class AudioWaveform: RCTEventEmitter {
                                  bitRate: args?[Constants.bitRate] as? Int,
                                  fileNameFormat: args?[Constants.fileNameFormat] as? String,
                                  useLegacy: args?[Constants.useLegacyNormalization] as? Bool,
+                                 engine: args?[Constants.engine] as? String,
+                                 waveformSamples: args?[Constants.waveformSamples] as? Int,
                                  resolver: resolve,
                                  rejecter: reject)
   }
@@ -98,50 +107,243 @@ class AudioWaveform: RCTEventEmitter {
     audioRecorder.getDecibel(resolve)
   }
   
-  @objc func extractWaveformData(_ args: NSDictionary?, resolver resolve: @escaping RCTPromiseResolveBlock, rejecter reject: RCTPromiseRejectBlock) -> Void {
+  @objc func extractWaveformData(_ args: NSDictionary?, resolver resolve: @escaping RCTPromiseResolveBlock, rejecter reject: @escaping RCTPromiseRejectBlock) -> Void {
     let key = args?[Constants.playerKey] as? String
     let path = args?[Constants.path] as? String
     let noOfSamples = args?[Constants.noOfSamples] as? Int
+    let withPeaks = args?[Constants.withPeaks] as? Bool ?? false
+    let useCache = args?[Constants.useCache] as? Bool ?? true
+    let priority = args?[Constants.priority] as? Int ?? 0
+    let binary = args?[Constants.binary] as? Bool ?? false
+    // Binary progress events are always deltas, a full copy per bucket would defeat the point
+    let progressMode: ProgressMode = binary ? .delta : ProgressMode(rawValue: args?[Constants.progressMode] as? String ?? "") ?? .full
+    let progressInterval = max(0, args?[Constants.progressInterval] as? Double ?? Constants.defaultProgressInterval)
+    let downloadPath = args?[Constants.downloadPath] as? String
+    let channelMode = ChannelMode(rawValue: args?[Constants.channelMode] as? String ?? "") ?? .mixdown
+    let preview = args?[Constants.preview] as? Bool ?? false
+    let scale = (args?[Constants.scale] as? NSNumber)?.floatValue ?? Constants.defaultNormalizationScale
+    let threshold = (args?[Constants.threshold] as? NSNumber)?.floatValue ?? Constants.defaultNormalizationThreshold
     if(key != nil) {
-      createOrUpdateExtractor(playerKey: key!, path: path, noOfSamples: noOfSamples, resolve: resolve, rejecter: reject)
+      createOrUpdateExtractor(playerKey: key!, path: path, noOfSamples: noOfSamples, withPeaks: withPeaks, useCache: useCache, priority: priority, progressMode: progressMode, progressInterval: progressInterval, binary: binary, downloadPath: downloadPath, channelMode: channelMode, preview: preview, scale: scale, threshold: threshold, resolve: resolve, rejecter: reject)
     } else {
       reject(Constants.audioWaveforms,"Can not get waveform data",nil)
     }
   }
   
-  func createOrUpdateExtractor(playerKey: String, path: String?, noOfSamples: Int?, resolve: @escaping RCTPromiseResolveBlock, rejecter reject: RCTPromiseRejectBlock) {
+  /// Extracts every item of `items` through the scheduler and resolves them concatenated in one
+  /// payload, with `lengths` to split it. Items run without progress events or peaks; one that
+  /// fails or is cancelled gets no values.
+  @objc func extractWaveformDataBatch(_ args: NSDictionary?, resolver resolve: @escaping RCTPromiseResolveBlock, rejecter reject: @escaping RCTPromiseRejectBlock) -> Void {
+    let items = args?[Constants.items] as? [NSDictionary] ?? []
+    let binary = args?[Constants.binary] as? Bool ?? false
+    let group = DispatchGroup()
+    // Items settle on the scheduler's queue
+    let lock = NSLock()
+    var results = [[Float]](repeating: [], count: items.count)
+    for (index, item) in items.enumerated() {
+      guard let key = item[Constants.playerKey] as? String else { continue }
+      let noOfSamples = item[Constants.noOfSamples] as? Int
+      let useCache = item[Constants.useCache] as? Bool ?? true
+      let priority = item[Constants.priority] as? Int ?? 0
+      let downloadPath = item[Constants.downloadPath] as? String
+      let channelMode = ChannelMode(rawValue: item[Constants.channelMode] as? String ?? "") ?? .mixdown
+      let scale = (item[Constants.scale] as? NSNumber)?.floatValue ?? Constants.defaultNormalizationScale
+      let threshold = (item[Constants.threshold] as? NSNumber)?.floatValue ?? Constants.defaultNormalizationThreshold
+      // An extraction that fails may resolve an error and reject as well
+      var isSettled = false
+      let settle = { (values: [Float]) in
+        lock.lock()
+        let isFirst = !isSettled
+        if isFirst {
+          isSettled = true
+          results[index] = values
+        }
+        lock.unlock()
+        if isFirst { group.leave() }
+      }
+      group.enter()
+      createOrUpdateExtractor(playerKey: key, path: item[Constants.path] as? String, noOfSamples: noOfSamples, withPeaks: false, useCache: useCache, priority: priority, progressMode: .none, progressInterval: 0, binary: false, downloadPath: downloadPath, channelMode: channelMode, preview: false, scale: scale, threshold: threshold, resolve: { value in
+        // Errors resolve as `[[code, message]]`, cancelled extractions as `[[]]`
+        settle((value as? [[Float]])?.first ?? [])
+      }, rejecter: { _, _, _ in
+        settle([])
+      })
+    }
+    group.notify(queue: .global(qos: .userInitiated)) {
+      let waveformData = Array(results.joined())
+      var output: [String: Any] = [Constants.lengths: results.map { $0.count }]
+      if binary {
+        output[Constants.bufferId] = waveformData.withUnsafeBufferPointer { AWBufferStorePut($0.baseAddress, $0.count, true) }
+      } else {
+        output[Constants.waveformData] = waveformData
+      }
+      resolve(output)
+    }
+  }
+  
+  func createOrUpdateExtractor(playerKey: String, path: String?, noOfSamples: Int?, withPeaks: Bool, useCache: Bool, priority: Int, progressMode: ProgressMode, progressInterval: Double, binary: Bool, downloadPath: String?, channelMode: ChannelMode, preview: Bool, scale: Float, threshold: Float, resolve: @escaping RCTPromiseResolveBlock, rejecter reject: @escaping RCTPromiseRejectBlock) {
+    // The peak cache only holds mixdown values
+    let useCache = useCache && channelMode == .mixdown
     if(!(path ?? "").isEmpty) {
-      do {
-        let audioUrl = URL.init(string: path!)
-        if(audioUrl == nil){
-          reject(Constants.audioWaveforms, "Failed to initialise Url from provided audio file If path contains `file://` try removing it", nil)
-            return
+      let audioUrl = URL.init(string: path!)
+      if(audioUrl == nil){
+        reject(Constants.audioWaveforms, "Failed to initialise Url from provided audio file If path contains `file://` try removing it", nil)
+          return
+      }
+      let extract = { [weak self] (fileUrl: URL) in
+        guard let self = self else { return }
+        if useCache, let cached = PeakCache.shared.load(path: fileUrl.path, bucketCount: max(1, noOfSamples ?? 100)) {
+          PerfStats.shared.record(playerKey) { $0.cacheHits += 1 }
+          var waveformData = cached.rms
+          self.normalizeWaveformData(&waveformData, maxValue: AWNormalizationMax(cached.rms, cached.rms.count, threshold), scale: scale, threshold: threshold)
+          AudioWaveform.resolveWaveform(resolve, rms: waveformData, peaks: withPeaks ? cached.peaks : nil, binary: binary)
+          return
         }
-        let newExtractor = try WaveformExtractor(url: audioUrl!, channel: self, resolve: resolve, rejecter: reject)
-        extractors[playerKey] = newExtractor
-        let data = newExtractor.extractWaveform(samplesPerPixel: noOfSamples, playerKey: playerKey)
-        newExtractor.cancel()
-        if(newExtractor.progress == 1.0) {
-          // Normalize the waveform data
-          let normalizedData = normalizeWaveformData(data: data!, scale: 0.12)
-          let waveformData = newExtractor.getChannelMean(data: normalizedData)
-          resolve([waveformData])
+        if useCache {
+          PerfStats.shared.record(playerKey) { $0.cacheMisses += 1 }
         }
-      } catch let e {
-        reject(Constants.audioWaveforms, "Failed to decode audio file", e)
+        self.scheduleExtraction(playerKey: playerKey, audioUrl: fileUrl, noOfSamples: noOfSamples, withPeaks: withPeaks, useCache: useCache, priority: priority, progressMode: progressMode, progressInterval: progressInterval, binary: binary, channelMode: channelMode, preview: preview, scale: scale, threshold: threshold, resolve: resolve, rejecter: reject)
+      }
+      if let scheme = audioUrl!.scheme?.lowercased(), scheme == "http" || scheme == "https" {
+        download(audioUrl!, to: downloadPath) { fileUrl, error in
+          if let fileUrl = fileUrl {
+            extract(fileUrl)
+          } else {
+            reject(Constants.audioWaveforms, "Failed to download audio file", error)
+          }
+        }
+        return
+      }
+      // The cache lookup reads a file as well, so it stays off the module's queue too
+      DispatchQueue.global(qos: .userInitiated).async {
+        extract(audioUrl!)
       }
     } else {
       reject(Constants.audioWaveforms, "Audio file path can't be empty or null", nil)
       
     }
   }
+  
+  /// AVAudioFile only reads local files, so an HTTP(S) file is downloaded first. With a
+  /// `downloadPath` it is kept there, where later extractions, the peak cache and the player find
+  /// it, otherwise it goes to a temporary file. Completes on a background queue.
+  private func download(_ url: URL, to downloadPath: String?, completion: @escaping (URL?, Error?) -> Void) {
+    if let downloadPath = downloadPath, FileManager.default.fileExists(atPath: downloadPath) {
+      DispatchQueue.global(qos: .userInitiated).async {
+        completion(URL(fileURLWithPath: downloadPath), nil)
+      }
+      return
+    }
+    URLSession.shared.downloadTask(with: url) { location, response, error in
+      guard let location = location, error == nil else {
+        completion(nil, error)
+        return
+      }
+      if let response = response as? HTTPURLResponse, !(200..<300).contains(response.statusCode) {
+        completion(nil, URLError(.badServerResponse))
+        return
+      }
+      // The extension tells AVAudioFile the container
+      let target = downloadPath.map { URL(fileURLWithPath: $0) }
+        ?? FileManager.default.temporaryDirectory.appendingPathComponent(UUID().uuidString).appendingPathExtension(url.pathExtension)
+      do {
+        try? FileManager.default.removeItem(at: target)
+        try FileManager.default.moveItem(at: location, to: target)
+        completion(target, nil)
+      } catch let moveError {
+        completion(nil, moveError)
+      }
+    }.resume()
+  }
 
-  func normalizeWaveformData(data: [[Float]], scale: Float = 0.25, threshold: Float = 0.01) -> [[Float]] {
-    return data.map { channelData in
-      let filteredData = channelData.filter { abs($0) >= threshold }
-      let maxAmplitude = filteredData.max() ?? 1.0
-      guard maxAmplitude > 0 else { return channelData }
-      return channelData.map { (abs($0) < threshold ? 0 : ($0 / maxAmplitude) * scale) }
+  private func scheduleExtraction(playerKey: String, audioUrl: URL, noOfSamples: Int?, withPeaks: Bool, useCache: Bool, priority: Int, progressMode: ProgressMode, progressInterval: Double, binary: Bool, channelMode: ChannelMode, preview: Bool, scale: Float, threshold: Float, resolve: @escaping RCTPromiseResolveBlock, rejecter reject: @escaping RCTPromiseRejectBlock) {
+    extractionScheduler.submit(key: playerKey, priority: priority, start: { [weak self] job in
+      defer { job.finish() }
+      guard let self = self else {
+        AudioWaveform.resolveWaveform(resolve, rms: [], peaks: nil, binary: binary)
+        return
+      }
+      do {
+        let decodeStart = CACurrentMediaTime()
+        let newExtractor = try PerfStats.shared.interval("startDecode") {
+          try WaveformExtractor(url: audioUrl, channel: self)
+        }
+        // Cancelled while the file was opened
+        guard job.onStop({ newExtractor.cancel() }) else {
+          AudioWaveform.resolveWaveform(resolve, rms: [], peaks: nil, binary: binary)
+          return
+        }
+        let data = try PerfStats.shared.interval("extractWaveform") {
+          try newExtractor.extractWaveform(samplesPerPixel: noOfSamples, playerKey: playerKey, buildPyramid: useCache, progressMode: progressMode, progressInterval: progressInterval, binary: binary, channelMode: channelMode, preview: preview, threshold: threshold)
+        }
+        if PerfStats.shared.isEnabled {
+          // AVAudioFile does not report its reads, so this is the share of the file decoded
+          let fileSize = ((try? FileManager.default.attributesOfItem(atPath: audioUrl.path))?[.size] as? NSNumber)?.int64Value ?? 0
+          PerfStats.shared.record(playerKey) {
+            $0.extractions += 1
+            $0.decodeMs += PerfStats.elapsedMs(since: decodeStart)
+            $0.reductionMs += newExtractor.reductionTime * 1000
+            $0.bytesRead += Int64(Double(fileSize) * Double(min(1, newExtractor.progress)))
+            $0.eventsEmitted += newExtractor.eventsEmitted
+          }
+        }
+        // Every way out settles the promise, the scheduler slot is freed either way
+        if newExtractor.isCancelled || data == nil {
+          // Same as a forced stop on Android, the hanging promise resolves with an empty waveform
+          AudioWaveform.resolveWaveform(resolve, rms: [], peaks: nil, binary: binary)
+        } else {
+          let rawData = data ?? []
+          var waveformData = rawData
+          let peaks = newExtractor.peakData
+          self.normalizeWaveformData(&waveformData, maxValue: newExtractor.normalizationMax, scale: scale, threshold: threshold)
+          // Peaks are returned un-normalized, as full-scale amplitudes
+          AudioWaveform.resolveWaveform(resolve, rms: waveformData, peaks: withPeaks ? peaks : nil, binary: binary)
+          // A file that ended short of noOfSamples resolves what was read, without caching it
+          if useCache && newExtractor.progress >= 1.0 {
+            let pyramid = newExtractor.takePyramid()
+            self.cacheQueue.async {
+              PeakCache.shared.store(path: audioUrl.path, rms: rawData, peaks: peaks, pyramid: pyramid)
+              if let pyramid = pyramid {
+                AWPyramidDestroy(pyramid)
+              }
+            }
+          }
+        }
+      } catch let e {
+        reject(Constants.audioWaveforms, "Failed to decode audio file: \(e.localizedDescription)", e)
+      }
+    }, onCancel: {
+      AudioWaveform.resolveWaveform(resolve, rms: [], peaks: nil, binary: binary)
+    })
+  }
+  
+  /// Resolves `rms` and, when given, `peaks` as arrays, or with `binary` as the ids of buffer
+  /// store entries that JS takes as Float32Arrays. A stopped extraction resolves an empty waveform,
+  /// in binary mode as the id of an empty buffer.
+  private static func resolveWaveform(_ resolve: RCTPromiseResolveBlock, rms: [Float], peaks: [Float]?, binary: Bool) {
+    let output = [rms] + (peaks.map { [$0] } ?? [])
+    if binary {
+      resolve(output.map { values in values.withUnsafeBufferPointer { AWBufferStorePut($0.baseAddress, $0.count, true) } })
+    } else {
+      resolve(output)
+    }
+  }
+
+  @objc func installJSIBindings() -> NSNumber {
+    return NSNumber(value: AWInstallJsiBindings(bridge))
+  }
+
+  /// Scales `data` in place so that `maxValue` becomes `scale`, zeroing values below `threshold`
+  func normalizeWaveformData(_ data: inout [Float], maxValue: Float, scale: Float, threshold: Float) {
+    guard maxValue > 0 else { return }
+    var threshold = threshold
+    var factor = scale / maxValue
+    let count = vDSP_Length(data.count)
+    data.withUnsafeMutableBufferPointer { values in
+      guard let base = values.baseAddress else { return }
+      /// Zero fill below the threshold, then a single multiply over the vector
+      vDSP_vthres(base, 1, &threshold, base, 1, count)
+      vDSP_vsmul(base, 1, &factor, base, 1, count)
     }
   }
   
@@ -150,9 +352,12 @@ class AudioWaveform: RCTEventEmitter {
     let key = args?[Constants.playerKey] as? String
     if(key != nil){
       initPlayer(playerKey: key!)
+      let signpost = PerfStats.shared.begin("preparePlayer")
+      defer { PerfStats.shared.end("preparePlayer", signpost) }
       audioPlayers[key!]?.preparePlayer(args?[Constants.path] as? String,
                                         volume: args?[Constants.volume] as? Double,
                                         updateFrequency: UpdateFrequency(rawValue: (args?[Constants.updateFrequency]) as? Double ?? 0) ?? UpdateFrequency.medium,
+                                        interpolatePosition: args?[Constants.interpolatePosition] as? Bool ?? false,
                                         time: args?[Constants.progress] as? Double ?? 0,
                                         resolver: resolve,
                                         rejecter: reject)
@@ -238,13 +443,104 @@ class AudioWaveform: RCTEventEmitter {
   }
   
   @objc func stopAllWaveFormExtractors(_ resolve: @escaping RCTPromiseResolveBlock, rejecter reject: RCTPromiseRejectBlock) -> Void {
-    for (extractorKey,_) in extractors{
-      extractors[extractorKey]?.cancel()
-    }
-    extractors.removeAll()
+    extractionScheduler.cancelAll()
     resolve(true)
   }
   
+  @objc func cancelWaveformExtraction(_ args: NSDictionary?, resolver resolve: @escaping RCTPromiseResolveBlock, rejecter reject: RCTPromiseRejectBlock) -> Void {
+    guard let key = args?[Constants.playerKey] as? String else {
+      reject(Constants.audioWaveforms, "Player key can't be null", nil)
+      return
+    }
+    resolve(extractionScheduler.cancel(key: key))
+  }
+  
+  /// `preparePlayer` and `extractWaveformData` of the same file in one call, with the arguments of
+  /// both. The player prepares while the extraction decodes instead of after it, and the promise
+  /// resolves with the waveform and the player's duration once both are done.
+  @objc func prepareWithWaveform(_ args: NSDictionary?, resolver resolve: @escaping RCTPromiseResolveBlock, rejecter reject: @escaping RCTPromiseRejectBlock) -> Void {
+    guard let key = args?[Constants.playerKey] as? String else {
+      reject(Constants.audioWaveforms, "Can not prepare player, Player key is null", nil)
+      return
+    }
+    let group = DispatchGroup()
+    // The extraction settles on the scheduler's queue
+    let lock = NSLock()
+    var result = [String: Any]()
+    // Only a failed extraction rejects, without a waveform there is nothing to show
+    var failure: (code: String?, message: String?, error: Error?)?
+
+    group.enter()
+    extractWaveformData(args, resolver: { waveformData in
+      lock.lock()
+      result[Constants.waveformData] = waveformData
+      lock.unlock()
+      group.leave()
+    }, rejecter: { code, message, error in
+      lock.lock()
+      failure = (code, message, error)
+      lock.unlock()
+      group.leave()
+    })
+
+    group.enter()
+    preparePlayer(args, resolver: { _ in
+      self.audioPlayers[key]?.getDuration(.Max) { duration in
+        lock.lock()
+        result[Constants.duration] = duration
+        lock.unlock()
+      }
+      group.leave()
+    }, rejecter: { _, message, _ in
+      // e.g. too many players, the waveform is still drawn and the player prepared on play
+      lock.lock()
+      result[Constants.duration] = -1
+      result[Constants.playerError] = message ?? "Could not prepare the player"
+      lock.unlock()
+      group.leave()
+    })
+
+    group.notify(queue: .global(qos: .userInitiated)) {
+      if let failure = failure {
+        reject(failure.code, failure.message, failure.error)
+      } else {
+        resolve(result)
+      }
+    }
+  }
+
+  @objc func prefetchPlayer(_ args: NSDictionary?, resolver resolve: @escaping RCTPromiseResolveBlock, rejecter reject: RCTPromiseRejectBlock) -> Void {
+    guard let path = args?[Constants.path] as? String, !path.isEmpty, let url = URL(string: path) else {
+      reject(Constants.audioWaveforms, "Audio file path can't be empty or null", nil)
+      return
+    }
+    do {
+      resolve(try playerPool.prefetch(path, url: url))
+    } catch let error as NSError {
+      reject(Constants.audioWaveforms, error.localizedDescription, error)
+    }
+  }
+
+  /// Turns the PerfStats counters on or off. Turning them off keeps what was counted.
+  @objc func setPerfStatsEnabled(_ args: NSDictionary?, resolver resolve: @escaping RCTPromiseResolveBlock, rejecter reject: RCTPromiseRejectBlock) -> Void {
+    PerfStats.shared.isEnabled = args?[Constants.enabled] as? Bool ?? false
+    resolve(PerfStats.shared.isEnabled)
+  }
+  
+  /// The PerfStats counters by player key, cleared afterwards with `reset`
+  @objc func getPerfStats(_ args: NSDictionary?, resolver resolve: @escaping RCTPromiseResolveBlock, rejecter reject: RCTPromiseRejectBlock) -> Void {
+    resolve(PerfStats.shared.snapshot(reset: args?[Constants.reset] as? Bool ?? false))
+  }
+  
+  @objc func setMaxConcurrentExtractions(_ args: NSDictionary?, resolver resolve: @escaping RCTPromiseResolveBlock, rejecter reject: RCTPromiseRejectBlock) -> Void {
+    guard let maxConcurrent = args?[Constants.maxConcurrentExtractions] as? Int else {
+      reject(Constants.audioWaveforms, "maxConcurrentExtractions can't be null", nil)
+      return
+    }
+    extractionScheduler.maxConcurrent = maxConcurrent
+    resolve(extractionScheduler.maxConcurrent)
+  }
+  
   
   func getUpdateFrequency(freq: Int?) -> Int{
     if(freq == 2){
@@ -0,0 +1,20 @@
+//
+//  AudioWaveformJsiInstaller.h
+//  AudioWaveform
+//
+//  Installs the shared JSI bindings (cpp/WaveformJsi.h) from Swift, which
+//  cannot reach the bridge's jsi::Runtime itself.
+//
+
+#import <Foundation/Foundation.h>
+
+@class RCTBridge;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/// Installs `global.__AudioWaveformJsi` into the JS runtime of `bridge`. Must be
+/// called on the JS thread. Returns NO when the runtime is not reachable, e.g.
+/// with remote debugging.
+FOUNDATION_EXPORT BOOL AWInstallJsiBindings(RCTBridge *_Nullable bridge);
+
+NS_ASSUME_NONNULL_END
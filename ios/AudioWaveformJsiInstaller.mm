@@ -0,0 +1,20 @@
+//
+//  AudioWaveformJsiInstaller.mm
+//  AudioWaveform
+//
+
+#import "AudioWaveformJsiInstaller.h"
+
+#import <React/RCTBridge+Private.h>
+#import <jsi/jsi.h>
+
+#include "WaveformJsi.h"
+
+BOOL AWInstallJsiBindings(RCTBridge *bridge) {
+  RCTCxxBridge *cxxBridge = (RCTCxxBridge *)bridge;
+  if (![cxxBridge respondsToSelector:@selector(runtime)] || cxxBridge.runtime == nullptr) {
+    return NO;
+  }
+  audiowaveform::installJsiBindings(*static_cast<facebook::jsi::Runtime *>(cxxBridge.runtime));
+  return YES;
+}
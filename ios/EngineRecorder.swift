@@ -0,0 +1,183 @@
+//
+//  EngineRecorder.swift
+//  AudioWaveform
+//
+
+import AVFoundation
+import Accelerate
+
+/// Recording engine on an `AVAudioEngine` input tap, written to the file with `AVAudioFile`.
+/// Unlike `AVAudioRecorder` it sees the PCM: each tap buffer is handed to a background queue,
+/// which measures a level for every 10 ms with vDSP and passes them to `onLevels` in batches of
+/// `batchInterval` from that queue, instead of one metering reading per timer tick. The same PCM
+/// feeds a peak pyramid that is stored in the peak cache once the file is finished.
+final class EngineRecorder {
+  private static let levelsPerSecond = 100
+  /// About 90 ms at 44.1 kHz, the tap is called about this often
+  private static let tapFrames: AVAudioFrameCount = 4096
+
+  let url: URL
+  private let settings: [String: Any]
+  private let batchInterval: TimeInterval
+  private let useLegacyNormalization: Bool
+  private let onLevels: ([Float]) -> Void
+  private let engine = AVAudioEngine()
+  private let queue = DispatchQueue(label: "AudioWaveformEngineRecorder", qos: .userInitiated)
+
+  // Only touched on `queue` once recording started
+  private var file: AVAudioFile?
+  private var pyramid: OpaquePointer?
+  private var sampleRate: Double = 0
+  private var framesPerLevel = 1
+  private var writtenFrames: Int64 = 0
+  private var isPaused = false
+  private var partialFrames = 0
+  private var partialPeak: Float = 0
+  private var partialSumOfSquares: Float = 0
+  private var batch = [Float]()
+  private var batchStart = DispatchTime.now()
+  private var lastLevel: Float = 0
+
+  /// `settings` are those of `AVAudioRecorder`; the tap's sample rate and a single channel replace
+  /// the ones given.
+  init(url: URL, settings: [String: Any], batchInterval: TimeInterval, useLegacyNormalization: Bool, onLevels: @escaping ([Float]) -> Void) {
+    self.url = url
+    self.settings = settings
+    self.batchInterval = batchInterval
+    self.useLegacyNormalization = useLegacyNormalization
+    self.onLevels = onLevels
+  }
+
+  deinit {
+    if let pyramid = pyramid {
+      AWPyramidDestroy(pyramid)
+    }
+  }
+
+  /// Opens the file and starts the engine. The audio session must already allow recording.
+  func start() throws {
+    let input = engine.inputNode
+    let format = input.outputFormat(forBus: 0)
+    guard format.sampleRate > 0, format.channelCount > 0,
+          let mono = AVAudioFormat(commonFormat: .pcmFormatFloat32, sampleRate: format.sampleRate, channels: 1, interleaved: false) else {
+      throw NSError(domain: Constants.audioWaveforms, code: -1, userInfo: [NSLocalizedDescriptionKey: "No audio input available"])
+    }
+    var fileSettings = settings
+    fileSettings[AVSampleRateKey] = format.sampleRate
+    fileSettings[AVNumberOfChannelsKey] = 1
+    file = try AVAudioFile(forWriting: url, settings: fileSettings, commonFormat: .pcmFormatFloat32, interleaved: false)
+    sampleRate = format.sampleRate
+    framesPerLevel = max(1, Int(format.sampleRate) / EngineRecorder.levelsPerSecond)
+    // The length is not known yet, so the pyramid keeps the finest base level
+    pyramid = AWPyramidCreate(1, 0, true)
+
+    input.installTap(onBus: 0, bufferSize: EngineRecorder.tapFrames, format: format) { [weak self] buffer, _ in
+      // The tap's buffer is reused once this returns, so its first channel is copied for the queue
+      guard let self = self, let source = buffer.floatChannelData, buffer.frameLength > 0,
+            let copy = AVAudioPCMBuffer(pcmFormat: mono, frameCapacity: buffer.frameLength),
+            let target = copy.floatChannelData else { return }
+      copy.frameLength = buffer.frameLength
+      memcpy(target[0], source[0], Int(buffer.frameLength) * MemoryLayout<Float>.size)
+      self.queue.async { self.process(copy) }
+    }
+    engine.prepare()
+    do {
+      try engine.start()
+    } catch {
+      input.removeTap(onBus: 0)
+      file = nil
+      throw error
+    }
+    batchStart = DispatchTime.now()
+  }
+
+  /// Buffers are still tapped while paused, but neither written nor metered
+  func setPaused(_ paused: Bool) {
+    queue.async { self.isPaused = paused }
+  }
+
+  /// The newest level, on the scale of `AVAudioRecorder` metering
+  var level: Float {
+    return queue.sync { lastLevel }
+  }
+
+  /// Stops the engine, finishes the file and calls `completion` on the recorder's queue with its
+  /// duration in milliseconds, or -1 if nothing was recorded.
+  func stop(_ completion: @escaping (Int64) -> Void) {
+    engine.inputNode.removeTap(onBus: 0)
+    engine.stop()
+    // Runs after the buffers tapped before the tap was removed
+    queue.async {
+      if !self.batch.isEmpty {
+        self.onLevels(self.batch)
+        self.batch.removeAll()
+      }
+      // AVAudioFile finishes the file when it is released
+      self.file = nil
+      if let pyramid = self.pyramid {
+        // The cache is keyed by the file's size and modification time, so only the finished file
+        if self.writtenFrames > 0 {
+          PeakCache.shared.store(path: self.url.path, pyramid: pyramid)
+        }
+        AWPyramidDestroy(pyramid)
+        self.pyramid = nil
+      }
+      completion(self.writtenFrames > 0 ? self.writtenFrames * 1000 / Int64(self.sampleRate) : -1)
+    }
+  }
+
+  private func process(_ buffer: AVAudioPCMBuffer) {
+    guard !isPaused, let file = file, let samples = buffer.floatChannelData?[0] else { return }
+    let frameCount = Int(buffer.frameLength)
+    do {
+      try file.write(from: buffer)
+      writtenFrames += Int64(frameCount)
+    } catch {
+      debugPrint("Failed to write the recording: \(error.localizedDescription)")
+      return
+    }
+    if let pyramid = pyramid {
+      AWPyramidProcessPlanar(pyramid, 0, samples, frameCount)
+    }
+    meter(samples, count: frameCount)
+    if !batch.isEmpty && DispatchTime.now().uptimeNanoseconds - batchStart.uptimeNanoseconds >= UInt64(batchInterval * 1_000_000_000) {
+      onLevels(batch)
+      batch.removeAll(keepingCapacity: true)
+      batchStart = DispatchTime.now()
+    }
+  }
+
+  /// Several levels per tap buffer, one per `framesPerLevel` frames; a level that straddles two
+  /// buffers is finished with the next one
+  private func meter(_ samples: UnsafePointer<Float>, count: Int) {
+    var offset = 0
+    while offset < count {
+      let length = min(framesPerLevel - partialFrames, count - offset)
+      var peak: Float = 0
+      var sumOfSquares: Float = 0
+      vDSP_maxmgv(samples + offset, 1, &peak, vDSP_Length(length))
+      vDSP_svesq(samples + offset, 1, &sumOfSquares, vDSP_Length(length))
+      partialPeak = max(partialPeak, peak)
+      partialSumOfSquares += sumOfSquares
+      partialFrames += length
+      offset += length
+      if partialFrames == framesPerLevel {
+        lastLevel = toLevel(peak: partialPeak, rms: (partialSumOfSquares / Float(framesPerLevel)).squareRoot())
+        AWLevelHistoryPush(lastLevel)
+        batch.append(lastLevel)
+        partialFrames = 0
+        partialPeak = 0
+        partialSumOfSquares = 0
+      }
+    }
+  }
+
+  /// Same scales as `AudioRecorder.getDecibelLevel`: the average power in dB with legacy
+  /// normalization, otherwise the linear peak
+  private func toLevel(peak: Float, rms: Float) -> Float {
+    if useLegacyNormalization {
+      return rms > 0 ? max(-160, 20 * log10(rms)) : -160
+    }
+    return min(1, peak)
+  }
+}
@@ -0,0 +1,190 @@
+//
+//  ExtractionScheduler.swift
+//  AudioWaveform
+//
+
+import Foundation
+import QuartzCore
+
+/// Runs waveform extractions on a background queue with at most `maxConcurrent` of them at once.
+/// Pending jobs start by descending priority, then in submission order. A job is tracked from the
+/// moment it leaves the queue, so it can be cancelled before it started too.
+final class ExtractionScheduler {
+  private struct Job {
+    let key: String
+    let priority: Int
+    let order: Int
+    let start: (RunningJob) -> Void
+    let onCancel: () -> Void
+    let submittedAt: CFTimeInterval
+  }
+  
+  /// A job taken from the queue, handed to its `start`
+  final class RunningJob {
+    let key: String
+    fileprivate weak var scheduler: ExtractionScheduler?
+    /// Guarded by the scheduler's lock. A cancelled job that did not start yet never does
+    fileprivate var isCancelled = false
+    fileprivate var stop: (() -> Void)?
+    private let finishLock = NSLock()
+    private var finished = false
+    
+    fileprivate init(key: String, scheduler: ExtractionScheduler) {
+      self.key = key
+      self.scheduler = scheduler
+    }
+    
+    /// Registers what stops the extraction once it is created. Returns false if the job was
+    /// cancelled meanwhile, the extraction must then not run.
+    func onStop(_ stop: @escaping () -> Void) -> Bool {
+      guard let scheduler = scheduler else { return false }
+      scheduler.lock.lock()
+      defer { scheduler.lock.unlock() }
+      guard !isCancelled else { return false }
+      self.stop = stop
+      return true
+    }
+    
+    /// Frees the slot once the extraction resolved, rejected or was stopped. Only the first call counts.
+    func finish() {
+      finishLock.lock()
+      let first = !finished
+      finished = true
+      finishLock.unlock()
+      if first { scheduler?.onFinished(self) }
+    }
+  }
+
+  /// Decoding many files at once mostly buys thermal throttling
+  private static let maxDefaultConcurrent = 4
+
+  /// Half the active cores, bounded by `maxDefaultConcurrent`. AVAudioFile decodes in software, so
+  /// there is no hardware codec count to size against on iOS.
+  static var defaultMaxConcurrent: Int {
+    return min(max(1, ProcessInfo.processInfo.activeProcessorCount / 2), maxDefaultConcurrent)
+  }
+
+  private let lock = NSLock()
+  private let workQueue = DispatchQueue(label: "AudioWaveformExtraction", qos: .userInitiated, attributes: .concurrent)
+  private var pending = [Job]()
+  /// Jobs taken from `pending`, whether started yet or not, until they finish
+  private var running = [RunningJob]()
+  private var submitted = 0
+  private var _maxConcurrent: Int
+
+  init(maxConcurrent: Int = ExtractionScheduler.defaultMaxConcurrent) {
+    _maxConcurrent = max(1, maxConcurrent)
+  }
+
+  var maxConcurrent: Int {
+    get {
+      lock.lock()
+      defer { lock.unlock() }
+      return _maxConcurrent
+    }
+    set {
+      lock.lock()
+      _maxConcurrent = max(1, newValue)
+      let ready = takeReadyJobs()
+      lock.unlock()
+      run(ready)
+    }
+  }
+
+  /// Queues `start` for `key`. Once it created its extraction it registers how to stop it with
+  /// `RunningJob.onStop`, and it must call `RunningJob.finish` once the extraction resolved,
+  /// rejected or was stopped, to free the slot. A job pending or running for `key` is replaced: a
+  /// pending one receives its `onCancel`, a running one is stopped.
+  func submit(key: String, priority: Int, start: @escaping (RunningJob) -> Void, onCancel: @escaping () -> Void) {
+    lock.lock()
+    let (replaced, stops) = cancel(where: { $0.key == key })
+    pending.append(Job(key: key, priority: priority, order: submitted, start: start, onCancel: onCancel, submittedAt: CACurrentMediaTime()))
+    submitted += 1
+    let ready = takeReadyJobs()
+    lock.unlock()
+    replaced.forEach { $0.onCancel() }
+    stops.forEach { $0() }
+    run(ready)
+  }
+
+  /// Cancels the pending and running jobs of `key`. Returns true if there were any.
+  @discardableResult
+  func cancel(key: String) -> Bool {
+    lock.lock()
+    let found = pending.contains { $0.key == key } || running.contains { $0.key == key && !$0.isCancelled }
+    let (cancelled, stops) = cancel(where: { $0.key == key })
+    lock.unlock()
+    cancelled.forEach { $0.onCancel() }
+    stops.forEach { $0() }
+    return found
+  }
+
+  func cancelAll() {
+    lock.lock()
+    let (cancelled, stops) = cancel(where: { _ in true })
+    lock.unlock()
+    cancelled.forEach { $0.onCancel() }
+    stops.forEach { $0() }
+  }
+
+  /// Removes the pending jobs whose key `matches` and marks the running ones cancelled. Returns the
+  /// removed jobs to settle and the stops of the started ones, both to call once `lock` is released.
+  /// Must be called with `lock` held
+  private func cancel(where matches: (String) -> Bool) -> ([Job], [() -> Void]) {
+    let removed = pending.filter { matches($0.key) }
+    pending.removeAll { matches($0.key) }
+    var stops = [() -> Void]()
+    for job in running where matches(job.key) && !job.isCancelled {
+      job.isCancelled = true
+      if let stop = job.stop {
+        stops.append(stop)
+      }
+    }
+    return (removed, stops)
+  }
+
+  /// Must be called with `lock` held
+  private func takeReadyJobs() -> [(Job, RunningJob)] {
+    var ready = [(Job, RunningJob)]()
+    while running.count < _maxConcurrent, !pending.isEmpty {
+      var next = 0
+      for index in pending.indices.dropFirst() {
+        let job = pending[index]
+        let best = pending[next]
+        if job.priority > best.priority || (job.priority == best.priority && job.order < best.order) {
+          next = index
+        }
+      }
+      let job = pending.remove(at: next)
+      let runningJob = RunningJob(key: job.key, scheduler: self)
+      running.append(runningJob)
+      ready.append((job, runningJob))
+    }
+    return ready
+  }
+
+  private func run(_ jobs: [(Job, RunningJob)]) {
+    for (job, runningJob) in jobs {
+      workQueue.async { [weak self] in
+        PerfStats.shared.record(job.key) { $0.queueWaitMs += PerfStats.elapsedMs(since: job.submittedAt) }
+        self?.lock.lock()
+        let isCancelled = runningJob.isCancelled
+        self?.lock.unlock()
+        if isCancelled {
+          runningJob.finish()
+          job.onCancel()
+          return
+        }
+        job.start(runningJob)
+      }
+    }
+  }
+
+  private func onFinished(_ job: RunningJob) {
+    lock.lock()
+    running.removeAll { $0 === job }
+    let ready = takeReadyJobs()
+    lock.unlock()
+    run(ready)
+  }
+}
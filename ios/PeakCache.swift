@@ -0,0 +1,44 @@
+//
+//  PeakCache.swift
+//  AudioWaveform
+//
+
+import Foundation
+
+/// On-disk cache of raw waveform peaks (cpp/PeakCache.h), keyed by path, size and mtime of the
+/// source file. A hit is served without opening an AVAudioFile.
+struct PeakCache {
+  static let shared = PeakCache(directory: FileManager.default.urls(for: .cachesDirectory, in: .userDomainMask)[0]
+    .appendingPathComponent(Constants.waveformCacheDirectory).path)
+  
+  let directory: String
+  
+  /// Raw RMS and peak values of `path` at `bucketCount` buckets, or nil on a miss
+  func load(path: String, bucketCount: Int) -> (rms: [Float], peaks: [Float])? {
+    guard bucketCount > 0 else { return nil }
+    var rms = [Float](zeros: bucketCount)
+    var peaks = [Float](zeros: bucketCount)
+    guard AWPeakCacheLoad(directory, path, bucketCount, &rms, &peaks) else { return nil }
+    return (rms, peaks)
+  }
+  
+  @discardableResult
+  func store(path: String, rms: [Float], peaks: [Float]) -> Bool {
+    guard !rms.isEmpty, rms.count == peaks.count else { return false }
+    return AWPeakCacheStore(directory, path, rms, peaks, rms.count)
+  }
+  
+  /// Adds every level of an `AWPyramid` so other sample counts are served without decoding
+  @discardableResult
+  func store(path: String, pyramid: OpaquePointer) -> Bool {
+    return AWPyramidStoreInCache(pyramid, directory, path, nil, nil, 0)
+  }
+  
+  /// Adds `rms` and `peaks` and, if given, every level of `pyramid` with a single write
+  @discardableResult
+  func store(path: String, rms: [Float], peaks: [Float], pyramid: OpaquePointer?) -> Bool {
+    guard let pyramid = pyramid else { return store(path: path, rms: rms, peaks: peaks) }
+    guard rms.count == peaks.count else { return store(path: path, pyramid: pyramid) }
+    return AWPyramidStoreInCache(pyramid, directory, path, rms, peaks, rms.count)
+  }
+}
@@ -0,0 +1,103 @@
+//
+//  PerfStats.swift
+//  AudioWaveform
+//
+
+import Foundation
+import QuartzCore
+import os.signpost
+
+/// Opt-in counters of extraction and playback per player key, read with getPerfStats. Nothing is
+/// counted until `isEnabled` is set. The phases are signposted under the `AudioWaveform`
+/// subsystem whether counting is on or not, so they show up in Instruments.
+final class PerfStats {
+  struct Entry {
+    var extractions = 0
+    /// Wall time from opening the file until the extraction stopped, reduction included
+    var decodeMs = 0.0
+    var reductionMs = 0.0
+    /// Bytes of the audio file read by AVAudioFile
+    var bytesRead: Int64 = 0
+    var cacheHits = 0
+    var cacheMisses = 0
+    /// Time spent pending in the ExtractionScheduler
+    var queueWaitMs = 0.0
+    var eventsEmitted = 0
+    /// From preparePlayer until the player started, of the latest prepare; -1 before
+    var prepareToFirstAudioMs = -1.0
+  }
+
+  static let shared = PerfStats()
+
+  private let lock = NSLock()
+  private var _isEnabled = false
+  private var entries = [String: Entry]()
+  private let log = OSLog(subsystem: "com.audiowaveform", category: "AudioWaveform")
+
+  var isEnabled: Bool {
+    get {
+      lock.lock()
+      defer { lock.unlock() }
+      return _isEnabled
+    }
+    set {
+      lock.lock()
+      _isEnabled = newValue
+      lock.unlock()
+    }
+  }
+
+  /// Applies `update` to the entry of `key`, if counting is on
+  func record(_ key: String, _ update: (inout Entry) -> Void) {
+    lock.lock()
+    defer { lock.unlock() }
+    guard _isEnabled else { return }
+    update(&entries[key, default: Entry()])
+  }
+
+  /// All entries keyed by player key, cleared afterwards with `reset`
+  func snapshot(reset: Bool) -> [String: Any] {
+    lock.lock()
+    defer { lock.unlock() }
+    let result = entries.mapValues { entry -> [String: Any] in
+      return [
+        "extractions": entry.extractions,
+        "decodeMs": entry.decodeMs,
+        "reductionMs": entry.reductionMs,
+        "bytesRead": entry.bytesRead,
+        "cacheHits": entry.cacheHits,
+        "cacheMisses": entry.cacheMisses,
+        "queueWaitMs": entry.queueWaitMs,
+        "eventsEmitted": entry.eventsEmitted,
+        "prepareToFirstAudioMs": entry.prepareToFirstAudioMs,
+      ]
+    }
+    if reset {
+      entries.removeAll()
+    }
+    return result
+  }
+
+  /// Milliseconds since `start`, a `CACurrentMediaTime()` reading
+  static func elapsedMs(since start: CFTimeInterval) -> Double {
+    return (CACurrentMediaTime() - start) * 1000
+  }
+
+  /// Starts the signpost interval `name`; hand the returned id to `end`, from any thread
+  func begin(_ name: StaticString) -> OSSignpostID {
+    let id = OSSignpostID(log: log)
+    os_signpost(.begin, log: log, name: name, signpostID: id)
+    return id
+  }
+
+  func end(_ name: StaticString, _ id: OSSignpostID) {
+    os_signpost(.end, log: log, name: name, signpostID: id)
+  }
+
+  /// Runs `block` inside the signpost interval `name`
+  func interval<T>(_ name: StaticString, _ block: () throws -> T) rethrows -> T {
+    let id = begin(name)
+    defer { end(name, id) }
+    return try block()
+  }
+}
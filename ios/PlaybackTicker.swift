@@ -0,0 +1,66 @@
+//
+//  PlaybackTicker.swift
+//  AudioWaveform
+//
+
+import Foundation
+
+/// One position ticker for all playing `AudioPlayer`s. Each tick snapshots the position of every
+/// registered player and sends them in a single onCurrentDurations event, instead of a timer and
+/// an event per player. Its state lives on the metering queue.
+final class PlaybackTicker {
+  private let queue = RepeatingTimer.meteringQueue
+  private var players = [String: AudioPlayer]()
+  /// The interval each registered player asked for
+  private var intervals = [String: TimeInterval]()
+  private var timer: RepeatingTimer?
+  private var interval: TimeInterval = 0
+
+  /// Adds `player` to the ticks, which run at the shortest interval of the registered players
+  func register(_ player: AudioPlayer, interval: TimeInterval) {
+    queue.async {
+      self.players[player.playerKey] = player
+      self.intervals[player.playerKey] = interval
+      self.schedule()
+    }
+  }
+
+  func unregister(playerKey: String) {
+    queue.async {
+      guard self.players.removeValue(forKey: playerKey) != nil else { return }
+      self.intervals.removeValue(forKey: playerKey)
+      self.schedule()
+    }
+  }
+
+  /// Ticks at the shortest interval of the registered players, so a fast player leaving slows the
+  /// ticks down again, and stops without players. Re-arms only when the interval changes.
+  private func schedule() {
+    guard let next = intervals.values.min() else {
+      timer?.cancel()
+      timer = nil
+      return
+    }
+    guard timer == nil || next != interval else { return }
+    interval = next
+    timer?.cancel()
+    timer = RepeatingTimer(interval: next, queue: queue) { [weak self] in
+      guard let self = self else { return }
+      self.send(self.players.values.compactMap { $0.positionSnapshot() })
+    }
+  }
+
+  /// Sends the current position of `player` right away, e.g. on start, pause or stop. The
+  /// position is read on the caller's thread, before the player may be torn down.
+  func emit(_ player: AudioPlayer) {
+    guard let snapshot = player.positionSnapshot() else { return }
+    queue.async {
+      self.send([snapshot])
+    }
+  }
+
+  private func send(_ durations: [[String: Any]]) {
+    guard !durations.isEmpty else { return }
+    EventEmitter.sharedInstance.dispatch(name: Constants.onCurrentDurations, body: [Constants.durations: durations])
+  }
+}
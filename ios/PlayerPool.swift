@@ -0,0 +1,69 @@
+//
+//  PlayerPool.swift
+//  AudioWaveform
+//
+
+import AVFoundation
+
+/// Keeps up to `maxIdle` prepared `AVAudioPlayer`s between plays, keyed by path. A stopped player
+/// is parked with its buffers primed, so playing the same file again skips opening and priming
+/// it, and `prefetch` does that ahead of a tap. Idle players are evicted least recently used first.
+final class PlayerPool {
+  /// Each parked player holds its file open and primed buffers
+  private static let maxIdle = 3
+
+  private let lock = NSLock()
+  /// Least recently used first
+  private var idle = [(path: String, player: AVAudioPlayer)]()
+
+  /// A prepared player for `path`: the parked one if it was prefetched or played before,
+  /// otherwise a new one. The caller owns it until `recycle`.
+  func acquire(_ path: String, url: URL) throws -> AVAudioPlayer {
+    if let player = take(path) {
+      return player
+    }
+    let player = try AVAudioPlayer(contentsOf: url)
+    player.prepareToPlay()
+    return player
+  }
+
+  /// Parks `player` at the start of `path`, primed again
+  func recycle(_ path: String, player: AVAudioPlayer) {
+    player.stop()
+    player.delegate = nil
+    player.currentTime = 0
+    player.rate = 1
+    player.volume = 1
+    player.prepareToPlay()
+    lock.lock()
+    idle.removeAll { $0.path == path }
+    idle.append((path, player))
+    if idle.count > PlayerPool.maxIdle {
+      idle.removeFirst(idle.count - PlayerPool.maxIdle)
+    }
+    lock.unlock()
+  }
+
+  /// Opens and primes a player for `path`. Returns false if one was already parked.
+  func prefetch(_ path: String, url: URL) throws -> Bool {
+    lock.lock()
+    let isParked = idle.contains { $0.path == path }
+    lock.unlock()
+    guard !isParked else { return false }
+    recycle(path, player: try acquire(path, url: url))
+    return true
+  }
+
+  func clear() {
+    lock.lock()
+    idle.removeAll()
+    lock.unlock()
+  }
+
+  private func take(_ path: String) -> AVAudioPlayer? {
+    lock.lock()
+    defer { lock.unlock() }
+    guard let index = idle.firstIndex(where: { $0.path == path }) else { return nil }
+    return idle.remove(at: index).player
+  }
+}
@@ -0,0 +1,41 @@
+//
+//  RepeatingTimer.swift
+//  AudioWaveform
+//
+
+import Foundation
+
+/// A repeating DispatchSourceTimer on a background queue. Metering and position updates then
+/// neither jitter while the main thread is busy nor take time from it.
+final class RepeatingTimer {
+  /// Shared by the recorder and all players, so their ticks are serialized and coalesced
+  static let meteringQueue = DispatchQueue(label: "AudioWaveformMetering", qos: .userInitiated)
+
+  private let source: DispatchSourceTimer
+  private let queue: DispatchQueue
+
+  init(interval: TimeInterval, queue: DispatchQueue = RepeatingTimer.meteringQueue, handler: @escaping () -> Void) {
+    self.queue = queue
+    source = DispatchSource.makeTimerSource(queue: queue)
+    // A tenth of the interval of leeway lets the system batch the wakeups with other timers
+    source.schedule(deadline: .now() + interval, repeating: interval, leeway: .milliseconds(max(1, Int(interval * 100))))
+    source.setEventHandler(handler: handler)
+    source.resume()
+  }
+
+  /// Stops the timer and waits for a running tick, so the handler's state can be torn down
+  /// right after. Must not be called from the handler itself.
+  func invalidate() {
+    source.cancel()
+    queue.sync {}
+  }
+
+  /// Stops the timer without waiting, for use from its own queue
+  func cancel() {
+    source.cancel()
+  }
+
+  deinit {
+    source.cancel()
+  }
+}
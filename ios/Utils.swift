@@ -54,8 +54,16 @@ struct Constants {
   static let durationType = "durationType"
   static let preparePlayer = "preparePlayer"
   static let onCurrentDuration = "onCurrentDuration"
+  static let onCurrentDurations = "onCurrentDurations"
+  static let durations = "durations"
   static let currentDuration = "currentDuration"
     static let currentDecibel = "currentDecibel"
+  static let levels = "levels"
+  static let engine = "engine"
+  static let pcmEngine = "pcm"
+  static let waveformSamples = "waveformSamples"
+  static let enabled = "enabled"
+  static let reset = "reset"
   static let playerKey = "playerKey"
   static let stopAllPlayers = "stopAllPlayers"
   static let stopAllWaveFormExtractors = "stopAllWaveFormExtractors"
@@ -65,15 +73,70 @@ struct Constants {
   static let finishType = "finishType"
   static let extractWaveformData = "extractWaveformData"
   static let noOfSamples = "noOfSamples"
+  static let withPeaks = "withPeaks"
+  static let useCache = "useCache"
+  static let priority = "priority"
+  static let progressMode = "progressMode"
+  static let progressInterval = "progressInterval"
+  static let fromIndex = "fromIndex"
+  static let binary = "binary"
+  static let downloadPath = "downloadPath"
+  static let channelMode = "channelMode"
+  static let preview = "preview"
+  static let scale = "scale"
+  static let threshold = "threshold"
+  /// Normalized waveforms peak at this, with values below the threshold zeroed
+  static let defaultNormalizationScale: Float = 0.12
+  static let defaultNormalizationThreshold: Float = 0.01
+  static let bufferId = "bufferId"
+  static let items = "items"
+  static let lengths = "lengths"
+  /// Default minimum time between two progress events in `ProgressMode.delta`, in milliseconds
+  static let defaultProgressInterval = 16.0
+  static let maxConcurrentExtractions = "maxConcurrentExtractions"
+  static let waveformCacheDirectory = "waveforms"
   static let onCurrentExtractedWaveformData = "onCurrentExtractedWaveformData"
     static let onCurrentRecordingWaveformData = "onCurrentRecordingWaveformData"
   static let waveformData = "waveformData"
+  static let duration = "duration"
+  static let playerError = "playerError"
   static let onExtractionProgressUpdate = "onExtractionProgressUpdate"
   static let useLegacyNormalization = "useLegacyNormalization"
   static let updateFrequency = "updateFrequency"
+  static let interpolatePosition = "interpolatePosition"
+  static let timestamp = "timestamp"
+  static let isPlaying = "isPlaying"
+  /// Position tick interval of players whose listeners extrapolate between ticks, in seconds
+  static let interpolatedUpdateInterval = 1.0
   static let onGetAudioBuffers = "onGetAudioBuffers"
 }
 
+enum ProgressMode : String {
+  /// All values extracted so far, at most once per progress interval
+  case full = "full"
+  /// Only the values added since the previous event, at most once per progress interval
+  case delta = "delta"
+  /// No events, only the resolved result
+  case none = "none"
+}
+
+enum ChannelMode : String {
+  /// One value per bucket over all channels
+  case mixdown = "mixdown"
+  /// One value per bucket, of the loudest channel
+  case max = "max"
+  /// All buckets of the first channel, then those of the next one
+  case perChannel = "perChannel"
+
+  var kernelMode: AWChannelMode {
+    switch self {
+    case .mixdown: return AWChannelModeMixdown
+    case .max: return AWChannelModeMax
+    case .perChannel: return AWChannelModePerChannel
+    }
+  }
+}
+
 enum FinishMode : Int{
   case loop = 0
   case pause = 1
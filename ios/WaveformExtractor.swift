@@ -7,6 +7,7 @@
 
 import Accelerate
 import AVFoundation
+import QuartzCore
 
 extension Notification.Name {
   static let audioRecorderManagerMeteringLevelDidUpdateNotification = Notification.Name("AudioRecorderManagerMeteringLevelDidUpdateNotification")
@@ -17,37 +18,80 @@ extension Notification.Name {
 
 public class WaveformExtractor {
   public private(set) var audioFile: AVAudioFile?
-  private var result: RCTPromiseResolveBlock
   var flutterChannel: AudioWaveform
-  private var waveformData = Array<Float>()
+  /// One value per bucket of the last extraction: the result, or with `ChannelMode.perChannel` the
+  /// mixdown that progress events carry
+  private var levels = [Float]()
+  /// Bucket peaks of the last extraction, laid out like the returned values
+  private(set) var peakData = [Float]()
+  /// Largest returned value at or above the threshold, tracked while extracting so that
+  /// normalization is a single scale. 1 if there is none, like `AWNormalizationMax`.
+  private(set) var normalizationMax: Float = 1.0
+  /// Multi-resolution pyramid of the whole file for the peak cache, see cpp/PeakPyramid.h
+  private var pyramid: OpaquePointer?
   var progress: Float = 0.0
   var channelCount: Int = 1
   private var currentProgress: Float = 0.0
+  /// First bucket not sent yet and the time of the last event in `ProgressMode.delta`
+  private var emittedIndex = 0
+  private var lastEmitTime: CFTimeInterval = 0
+  /// Time spent in the reducer and pyramid during the last extraction, in seconds, for PerfStats
+  private(set) var reductionTime: CFTimeInterval = 0
+  /// Progress and preview events sent, for PerfStats
+  private(set) var eventsEmitted = 0
+  /// Sends delta slices as buffer store ids instead of arrays, see cpp/WaveformBufferStore.h
+  private var binary = false
+  /// Frames decoded per sequential read
+  private static let chunkFrameCount: AVAudioFrameCount = 64 * 1024
+  /// Windows spread across the file for a preview, and the frames read for each
+  private static let maxPreviewWindows = 100
+  private static let previewWindowFrames: AVAudioFrameCount = 2048
+  /// Shorter files are extracted in full about as fast
+  private static let minPreviewDuration: Double = 30
   private let abortWaveformDataQueue = DispatchQueue(label: "WaveformExtractor",attributes: .concurrent)
   
   private var _abortGetWaveformData: Bool = false
   
+  /// Read by the extraction loop on the scheduler's queue and set by `cancel()` from the module's
+  /// queue, so access goes through `abortWaveformDataQueue`
   public var abortGetWaveformData: Bool {
-    get { _abortGetWaveformData }
+    get { abortWaveformDataQueue.sync { _abortGetWaveformData } }
     set {
-        _abortGetWaveformData = newValue
+      abortWaveformDataQueue.async(flags: .barrier) {
+        self._abortGetWaveformData = newValue
+      }
     }
-}
-  init(url: URL, channel: AudioWaveform, resolve: @escaping RCTPromiseResolveBlock, rejecter reject: RCTPromiseRejectBlock) throws {
+  }
+  
+  /// True once an extraction stopped early because of `cancel()`
+  public var isCancelled: Bool { abortGetWaveformData }
+  init(url: URL, channel: AudioWaveform) throws {
     audioFile = try AVAudioFile(forReading: url)
-    result = resolve
     self.flutterChannel = channel
   }
   
   deinit {
+    if let pyramid = pyramid {
+      AWPyramidDestroy(pyramid)
+    }
     audioFile = nil
   }
   
+  /// The values of the buckets read, fewer than requested if the file ends first, or nil once
+  /// cancelled. Throws when the file can not be read.
   public func extractWaveform(samplesPerPixel: Int?,
                               offset: Int? = 0,
-                              length: UInt? = nil, playerKey: String) -> FloatChannelData?
+                              length: UInt? = nil, playerKey: String,
+                              buildPyramid: Bool = false,
+                              progressMode: ProgressMode = .full,
+                              progressInterval: Double = Constants.defaultProgressInterval,
+                              binary: Bool = false,
+                              channelMode: ChannelMode = .mixdown,
+                              preview: Bool = false,
+                              threshold: Float = Constants.defaultNormalizationThreshold) throws -> [Float]?
   {
-    guard let audioFile = audioFile else { return nil }
+    guard let audioFile = audioFile else { throw extractionError("The audio file is not open") }
+    self.binary = binary
     
     /// prevent division by zero, + minimum resolution
     let samplesPerPixel = max(1, samplesPerPixel ?? 100)
@@ -55,19 +99,21 @@ public class WaveformExtractor {
     let currentFrame = audioFile.framePosition
     
     let totalFrameCount = AVAudioFrameCount(audioFile.length)
-    var framesPerBuffer: AVAudioFrameCount = totalFrameCount / AVAudioFrameCount(samplesPerPixel)
+    let framesPerBucket: AVAudioFrameCount = max(1, totalFrameCount / AVAudioFrameCount(samplesPerPixel))
     
-    guard let rmsBuffer = AVAudioPCMBuffer(pcmFormat: audioFile.processingFormat,
-                                           frameCapacity: AVAudioFrameCount(framesPerBuffer)) else { return nil }
+    /// The file is decoded front to back in large chunks instead of one seek and read per bucket
+    guard let chunkBuffer = AVAudioPCMBuffer(pcmFormat: audioFile.processingFormat,
+                                             frameCapacity: WaveformExtractor.chunkFrameCount) else {
+      throw extractionError("Unsupported audio format")
+    }
     
     channelCount = Int(audioFile.processingFormat.channelCount)
-    var data = Array(repeating: [Float](zeros: samplesPerPixel), count: channelCount)
     
     var start: Int
     if let offset = offset, offset >= 0 {
       start = offset
     } else {
-      start = Int(currentFrame / Int64(framesPerBuffer))
+      start = Int(currentFrame / Int64(framesPerBucket))
       if let offset = offset, offset < 0 {
         start += offset
       }
@@ -76,7 +122,16 @@ public class WaveformExtractor {
         start = 0
       }
     }
-    var startFrame: AVAudioFramePosition = offset == nil ? currentFrame : Int64(start * Int(framesPerBuffer))
+    let startFrame: AVAudioFramePosition = offset == nil ? currentFrame : Int64(start * Int(framesPerBucket))
+    
+    if let pyramid = pyramid {
+      AWPyramidDestroy(pyramid)
+      self.pyramid = nil
+    }
+    /// Only a read of the whole file can seed the pyramid
+    if buildPyramid && start == 0 && length == nil {
+      pyramid = AWPyramidCreate(Int32(channelCount), Int64(totalFrameCount), true)
+    }
     
     var end = samplesPerPixel
     if let length = length {
@@ -87,81 +142,195 @@ public class WaveformExtractor {
       end = samplesPerPixel
     }
     if start > end {
-      let resultsDict = ["code": Constants.audioWaveforms, "message": "offset is larger than total length. Please select less number of samples"] as [String : Any];
-      result([resultsDict])
-      
-      return nil
+      throw extractionError("offset is larger than total length. Please select less number of samples")
+    }
+    
+    /// The reducer keeps the partial bucket at the end of a chunk for the next one
+    guard let reducer = AWReducerCreate(Int32(channelCount), Int64(framesPerBucket), channelMode.kernelMode) else {
+      throw extractionError("Unsupported channel count \(channelCount)")
+    }
+    defer { AWReducerDestroy(reducer) }
+    let valuesPerBucket = AWReducerValuesPerBucket(reducer)
+    let chunkCapacity = Int(WaveformExtractor.chunkFrameCount / framesPerBucket) + 1
+    var rmsChunk = [Float](zeros: chunkCapacity * valuesPerBucket)
+    var peakChunk = [Float](zeros: chunkCapacity * valuesPerBucket)
+    levels = [Float](zeros: samplesPerPixel)
+    peakData = [Float](zeros: samplesPerPixel * valuesPerBucket)
+    var maxLevel: Float?
+    /// With `ChannelMode.perChannel`, all buckets of the first channel, then those of the next one
+    var channelData = [Float](zeros: valuesPerBucket > 1 ? samplesPerPixel * valuesPerBucket : 0)
+    
+    if preview && start == 0 && length == nil {
+      emitPreview(audioFile: audioFile, samplesPerPixel: samplesPerPixel, playerKey: playerKey)
     }
     
-    for i in start ..< end {
+    audioFile.framePosition = startFrame
+    var bucket = start
+    emittedIndex = start
+    lastEmitTime = 0
+    while bucket < end {
       
       if abortGetWaveformData {
         audioFile.framePosition = currentFrame
-        abortGetWaveformData = false
         return nil
       }
       
       do {
-        audioFile.framePosition = startFrame
-        /// Read portion of the buffer
-        try audioFile.read(into: rmsBuffer, frameCount: framesPerBuffer)
-        
+        try audioFile.read(into: chunkBuffer, frameCount: WaveformExtractor.chunkFrameCount)
       } catch let err as NSError {
-        let resultsDict = ["code": Constants.audioWaveforms, "message": "Couldn't read into buffer. \(err)"] as [String : Any];
-        result([resultsDict])
-        
-        return nil
+        audioFile.framePosition = currentFrame
+        throw extractionError("Couldn't read into buffer. \(err)")
       }
       
-      guard let floatData = rmsBuffer.floatChannelData else { return nil }
-      /// Calculating RMS(Root mean square)
-      for channel in 0 ..< channelCount {
-        var rms: Float = 0.0
-        vDSP_rmsqv(floatData[channel], 1, &rms, vDSP_Length(rmsBuffer.frameLength))
-        data[channel][i] = rms
-        
+      guard let floatData = chunkBuffer.floatChannelData else {
+        audioFile.framePosition = currentFrame
+        throw extractionError("Unsupported audio format")
       }
+      let frameLength = Int(chunkBuffer.frameLength)
+      let isLastChunk = frameLength == 0 || audioFile.framePosition >= audioFile.length
+      let capacity = min(end - bucket, chunkCapacity)
+      /// Calculating RMS(Root mean square) of all channels in one pass with the shared C++ kernel
+      let reductionStart = CACurrentMediaTime()
+      let channels = UnsafeRawPointer(floatData).assumingMemoryBound(to: UnsafePointer<Float>?.self)
+      var written = AWReducerProcessPlanar(reducer, channels, frameLength, &rmsChunk, &peakChunk, capacity)
+      if isLastChunk && written < capacity {
+        /// The trailing frames form a last, shorter bucket
+        let first = written * valuesPerBucket
+        let flushed = rmsChunk.withUnsafeMutableBufferPointer { rms in
+          peakChunk.withUnsafeMutableBufferPointer { peaks in
+            AWReducerFlush(reducer, rms.baseAddress! + first, peaks.baseAddress! + first)
+          }
+        }
+        written += flushed
+      }
+      for index in 0 ..< written {
+        let target = bucket + index
+        if valuesPerBucket == 1 {
+          levels[target] = rmsChunk[index]
+          peakData[target] = peakChunk[index]
+          if rmsChunk[index] >= threshold && rmsChunk[index] > maxLevel ?? -Float.infinity {
+            maxLevel = rmsChunk[index]
+          }
+          continue
+        }
+        /// Progress gets the same value `ChannelMode.mixdown` would have produced
+        var sumOfSquares: Float = 0.0
+        for channel in 0 ..< valuesPerBucket {
+          let value = rmsChunk[index * valuesPerBucket + channel]
+          channelData[channel * samplesPerPixel + target] = value
+          if value >= threshold && value > maxLevel ?? -Float.infinity {
+            maxLevel = value
+          }
+          peakData[channel * samplesPerPixel + target] = peakChunk[index * valuesPerBucket + channel]
+          sumOfSquares += value * value
+        }
+        levels[target] = (sumOfSquares / Float(valuesPerBucket)).squareRoot()
+      }
+      if let pyramid = pyramid {
+        for channel in 0 ..< channelCount {
+          AWPyramidProcessPlanar(pyramid, Int32(channel), floatData[channel], frameLength)
+        }
+      }
+      reductionTime += CACurrentMediaTime() - reductionStart
       
-      /// Update progress
-      currentProgress += 1
+      currentProgress += Float(written)
       progress = currentProgress / Float(samplesPerPixel)
-      
-      /// Send to RN channel
-      self.sendEvent(withName: Constants.onCurrentExtractedWaveformData, body:[Constants.waveformData: getChannelMean(data: data) as Any, Constants.progress: progress, Constants.playerKey: playerKey])
-      
-      startFrame += AVAudioFramePosition(framesPerBuffer)
-      
-      if startFrame + AVAudioFramePosition(framesPerBuffer) > totalFrameCount {
-        framesPerBuffer = totalFrameCount - AVAudioFrameCount(startFrame)
-        if framesPerBuffer <= 0 { break }
+      if progress >= 1.0 || CACurrentMediaTime() - lastEmitTime >= progressInterval / 1000 {
+        emitPending(upTo: bucket + written, progressMode: progressMode, playerKey: playerKey)
       }
+      bucket += written
+      
+      if isLastChunk { break }
     }
+    emitPending(upTo: bucket, progressMode: progressMode, playerKey: playerKey)
     
     audioFile.framePosition = currentFrame
+    normalizationMax = maxLevel ?? 1.0
     
-    return data
+    if valuesPerBucket > 1 {
+      return channelData
+    }
+    if bucket < samplesPerPixel {
+      /// A file that ended early, like on Android only the buckets read are returned
+      levels.removeSubrange(bucket...)
+      peakData.removeSubrange(bucket...)
+    }
+    /// Hands the storage over, so that normalizing the result in place does not copy it
+    defer { levels = [] }
+    return levels
   }
-  
-  func sendEvent(withName: String, body: Any?) {
-    EventEmitter.sharedInstance.dispatch(name: withName, body: body)
+
+  private func extractionError(_ message: String) -> NSError {
+    return NSError(domain: Constants.audioWaveforms, code: -1, userInfo: [NSLocalizedDescriptionKey: message])
   }
   
-  func getChannelMean(data: FloatChannelData) -> [Float] {
-    waveformData.removeAll()
-    if(channelCount == 2 && data[0].isEmpty == false && data[1].isEmpty == false) {
-      for (ele1, ele2) in zip(data[0], data[1]) {
-        waveformData.append((ele1 + ele2) / 2)
+  /// Sends an approximate waveform of a long file ahead of the full pass, from short windows read
+  /// at sparse frame positions, each bucket taking the level of the nearest window. The events of
+  /// the full pass refine it.
+  private func emitPreview(audioFile: AVAudioFile, samplesPerPixel: Int, playerKey: String) {
+    let format = audioFile.processingFormat
+    guard Double(audioFile.length) / format.sampleRate >= WaveformExtractor.minPreviewDuration,
+          let buffer = AVAudioPCMBuffer(pcmFormat: format, frameCapacity: WaveformExtractor.previewWindowFrames),
+          let reducer = AWReducerCreate(Int32(format.channelCount), Int64(WaveformExtractor.previewWindowFrames), AWChannelModeMixdown) else { return }
+    defer { AWReducerDestroy(reducer) }
+    let windows = min(samplesPerPixel, WaveformExtractor.maxPreviewWindows)
+    var windowLevels = [Float](zeros: windows)
+    for window in 0 ..< windows {
+      if abortGetWaveformData { return }
+      /// The middle of each window's share of the file
+      audioFile.framePosition = audioFile.length * Int64(2 * window + 1) / Int64(2 * windows)
+      guard (try? audioFile.read(into: buffer, frameCount: WaveformExtractor.previewWindowFrames)) != nil,
+            let floatData = buffer.floatChannelData else { return }
+      let channels = UnsafeRawPointer(floatData).assumingMemoryBound(to: UnsafePointer<Float>?.self)
+      var rms: Float = 0.0
+      var peak: Float = 0.0
+      if AWReducerProcessPlanar(reducer, channels, Int(buffer.frameLength), &rms, &peak, 1) == 0 {
+        AWReducerFlush(reducer, &rms, &peak)
       }
-    } else if(data[0].isEmpty == false) {
-      waveformData = data[0]
+      windowLevels[window] = rms
     }
-    else if (data[1].isEmpty == false) {
-      waveformData = data[1]
+    let values = (0 ..< samplesPerPixel).map { windowLevels[$0 * windows / samplesPerPixel] }
+    var body: [String: Any] = [Constants.preview: true, Constants.progress: 0, Constants.playerKey: playerKey]
+    if binary {
+      body[Constants.bufferId] = values.withUnsafeBufferPointer { AWBufferStorePut($0.baseAddress, $0.count, false) }
     } else {
-      let resultsDict = ["code": Constants.audioWaveforms, "message": "Can not get waveform mean. Both audio channels are null"] as [String : Any];
-      result([resultsDict])
+      body[Constants.waveformData] = values
     }
-    return waveformData
+    self.sendEvent(withName: Constants.onCurrentExtractedWaveformData, body: body)
+  }
+  
+  /// Sends the levels of buckets up to `index` not sent yet: all levels so far in `ProgressMode.full`,
+  /// otherwise the `fromIndex` slice from `emittedIndex` on
+  private func emitPending(upTo index: Int, progressMode: ProgressMode, playerKey: String) {
+    guard index > emittedIndex, progressMode != .none else { return }
+    if progressMode == .full {
+      /// Send to RN channel
+      self.sendEvent(withName: Constants.onCurrentExtractedWaveformData, body:[Constants.waveformData: levels, Constants.progress: progress, Constants.playerKey: playerKey])
+      emittedIndex = index
+      lastEmitTime = CACurrentMediaTime()
+      return
+    }
+    let values = Array(levels[emittedIndex ..< index])
+    var body: [String: Any] = [Constants.fromIndex: emittedIndex, Constants.progress: progress, Constants.playerKey: playerKey]
+    if binary {
+      body[Constants.bufferId] = values.withUnsafeBufferPointer { AWBufferStorePut($0.baseAddress, $0.count, false) }
+    } else {
+      body[Constants.waveformData] = values
+    }
+    self.sendEvent(withName: Constants.onCurrentExtractedWaveformData, body: body)
+    emittedIndex = index
+    lastEmitTime = CACurrentMediaTime()
+  }
+  
+  func sendEvent(withName: String, body: Any?) {
+    eventsEmitted += 1
+    EventEmitter.sharedInstance.dispatch(name: withName, body: body)
+  }
+  
+  /// Hands the pyramid of the last extraction over to the caller, which stores and destroys it
+  func takePyramid() -> OpaquePointer? {
+    defer { pyramid = nil }
+    return pyramid
   }
   
   public func cancel() {
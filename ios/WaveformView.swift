@@ -0,0 +1,170 @@
+//
+//  WaveformView.swift
+//  AudioWaveform
+//
+
+import UIKit
+
+/// Draws a whole waveform as candles in two shape layers sharing one path, the scrub colored one
+/// on top and masked up to `progress`. The path is only rebuilt when the samples or the geometry
+/// change, so a progress update just moves the mask. While `playing`, the playhead is extrapolated
+/// from the last progress and `progressRate` on a display link, between the native position events.
+class WaveformView: UIView {
+  /// WaveformCandle keeps 10 points of the container free
+  private static let verticalInset: CGFloat = 10
+
+  private let waveLayer = CAShapeLayer()
+  private let scrubLayer = CAShapeLayer()
+  private let scrubMask = CALayer()
+
+  @objc var samples: [NSNumber] = [] {
+    didSet { setNeedsLayout() }
+  }
+  @objc var candleWidth: CGFloat = 5 {
+    didSet { setNeedsLayout() }
+  }
+  @objc var candleSpace: CGFloat = 2 {
+    didSet { setNeedsLayout() }
+  }
+  @objc var candleHeightScale: CGFloat = 3 {
+    didSet { setNeedsLayout() }
+  }
+  /// Played fraction of the waveform, from 0 to 1, at `progressTimestamp`
+  @objc var progress: CGFloat = 0 {
+    didSet {
+      progressSetAt = Date().timeIntervalSince1970 * 1000
+      updateScrubMask()
+    }
+  }
+  /// Wall clock time in milliseconds the `progress` was measured at, 0 for when it was set
+  @objc var progressTimestamp: Double = 0 {
+    didSet { updateScrubMask() }
+  }
+  /// Fraction of the waveform played per millisecond while `playing`
+  @objc var progressRate: Double = 0 {
+    didSet { updateDisplayLink() }
+  }
+  /// While true the playhead is extrapolated from `progress` on every frame
+  @objc var playing: Bool = false {
+    didSet { updateDisplayLink() }
+  }
+
+  private var progressSetAt: Double = 0
+  private var displayLink: CADisplayLink?
+  @objc var waveColor: UIColor? {
+    didSet { waveLayer.fillColor = (waveColor ?? WaveformView.defaultWaveColor).cgColor }
+  }
+  @objc var scrubColor: UIColor? {
+    didSet { scrubLayer.fillColor = (scrubColor ?? WaveformView.defaultScrubColor).cgColor }
+  }
+
+  /// Colors.waveStickBackground and Colors.waveStickCompleteBackground of the JS theme
+  private static let defaultWaveColor = UIColor(red: 0x54 / 255.0, green: 0x54 / 255.0, blue: 0x54 / 255.0, alpha: 1)
+  private static let defaultScrubColor = UIColor(red: 0x7b / 255.0, green: 0x7b / 255.0, blue: 0x7b / 255.0, alpha: 1)
+
+  override init(frame: CGRect) {
+    super.init(frame: frame)
+    waveLayer.fillColor = WaveformView.defaultWaveColor.cgColor
+    scrubLayer.fillColor = WaveformView.defaultScrubColor.cgColor
+    scrubMask.backgroundColor = UIColor.black.cgColor
+    scrubMask.anchorPoint = .zero
+    scrubLayer.mask = scrubMask
+    layer.addSublayer(waveLayer)
+    layer.addSublayer(scrubLayer)
+  }
+
+  required init?(coder: NSCoder) {
+    fatalError("init(coder:) has not been implemented")
+  }
+
+  override func layoutSubviews() {
+    super.layoutSubviews()
+    CATransaction.begin()
+    CATransaction.setDisableActions(true)
+    let path = candlePath()
+    waveLayer.frame = bounds
+    scrubLayer.frame = bounds
+    waveLayer.path = path
+    scrubLayer.path = path
+    CATransaction.commit()
+    updateScrubMask()
+  }
+
+  /// Same geometry as the JS WaveformCandle: centered, at least as tall as wide, fully rounded
+  private func candlePath() -> CGPath {
+    let path = CGMutablePath()
+    guard candleWidth > 0 else { return path }
+    let maxHeight = max(0, bounds.height - WaveformView.verticalInset)
+    let step = candleWidth + candleSpace
+    let radius = candleWidth / 2
+    for (index, sample) in samples.enumerated() {
+      let left = CGFloat(index) * step
+      if left > bounds.width { break }
+      let amplitude = sample.doubleValue.isNaN ? 0 : CGFloat(sample.doubleValue)
+      let height = min(max(amplitude * maxHeight * candleHeightScale, min(candleWidth, maxHeight)), maxHeight)
+      let rect = CGRect(x: left, y: (bounds.height - height) / 2, width: candleWidth, height: height)
+      path.addRoundedRect(in: rect, cornerWidth: min(radius, height / 2), cornerHeight: min(radius, height / 2))
+    }
+    return path
+  }
+
+  override func didMoveToWindow() {
+    super.didMoveToWindow()
+    updateDisplayLink()
+  }
+
+  private func updateDisplayLink() {
+    let shouldRun = playing && progressRate > 0 && window != nil
+    if shouldRun, displayLink == nil {
+      // The link retains its target, so it goes through a weak proxy to let the view deallocate
+      let link = CADisplayLink(target: DisplayLinkProxy(self), selector: #selector(DisplayLinkProxy.tick))
+      link.add(to: .main, forMode: .common)
+      displayLink = link
+    } else if !shouldRun, let link = displayLink {
+      link.invalidate()
+      displayLink = nil
+    }
+    updateScrubMask()
+  }
+
+  fileprivate func displayLinkTick() {
+    updateScrubMask()
+  }
+
+  private func currentProgress() -> CGFloat {
+    guard playing, progressRate > 0 else { return min(max(progress, 0), 1) }
+    let anchor = progressTimestamp > 0 ? progressTimestamp : progressSetAt
+    let elapsed = max(0, Date().timeIntervalSince1970 * 1000 - anchor)
+    // Clamped after extrapolating, a window of a zoomed waveform starts out before its first candle
+    return min(max(progress + CGFloat(elapsed * progressRate), 0), 1)
+  }
+
+  private func updateScrubMask() {
+    // A candle is played as a whole once the progress passed its start, like WaveformCandle
+    let splitX = ceil(currentProgress() * CGFloat(samples.count)) * (candleWidth + candleSpace)
+    let frame = CGRect(x: 0, y: 0, width: min(splitX, bounds.width), height: bounds.height)
+    // Most display link frames stay within the same candle, those leave the layers untouched
+    if scrubMask.frame == frame { return }
+    CATransaction.begin()
+    CATransaction.setDisableActions(true)
+    scrubMask.frame = frame
+    CATransaction.commit()
+  }
+}
+
+private final class DisplayLinkProxy: NSObject {
+  private weak var view: WaveformView?
+
+  init(_ view: WaveformView) {
+    self.view = view
+    super.init()
+  }
+
+  @objc func tick(_ link: CADisplayLink) {
+    guard let view = view else {
+      link.invalidate()
+      return
+    }
+    view.displayLinkTick()
+  }
+}
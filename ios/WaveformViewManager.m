@@ -0,0 +1,22 @@
+//
+//  WaveformViewManager.m
+//  AudioWaveform
+//
+
+#import <Foundation/Foundation.h>
+#import <React/RCTViewManager.h>
+
+@interface RCT_EXTERN_MODULE(AudioWaveformViewManager, RCTViewManager)
+
+RCT_EXPORT_VIEW_PROPERTY(samples, NSArray)
+RCT_EXPORT_VIEW_PROPERTY(progress, CGFloat)
+RCT_EXPORT_VIEW_PROPERTY(progressTimestamp, double)
+RCT_EXPORT_VIEW_PROPERTY(progressRate, double)
+RCT_EXPORT_VIEW_PROPERTY(playing, BOOL)
+RCT_EXPORT_VIEW_PROPERTY(candleWidth, CGFloat)
+RCT_EXPORT_VIEW_PROPERTY(candleSpace, CGFloat)
+RCT_EXPORT_VIEW_PROPERTY(candleHeightScale, CGFloat)
+RCT_EXPORT_VIEW_PROPERTY(waveColor, UIColor)
+RCT_EXPORT_VIEW_PROPERTY(scrubColor, UIColor)
+
+@end
@@ -0,0 +1,17 @@
+//
+//  WaveformViewManager.swift
+//  AudioWaveform
+//
+
+import Foundation
+
+@objc(AudioWaveformViewManager)
+class WaveformViewManager: RCTViewManager {
+  override func view() -> UIView! {
+    return WaveformView()
+  }
+
+  @objc override static func requiresMainQueueSetup() -> Bool {
+    return true
+  }
+}
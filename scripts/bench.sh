@@ -0,0 +1,44 @@
+#!/bin/bash
+
+# Benchmarks for react-native-audio-waveform
+# Usage: ./scripts/bench.sh kernel              Reduction kernel throughput on this machine, after a
+#                                               check of the pyramid and the per channel kernels
+#        ./scripts/bench.sh fixtures [dir]      Writes the extraction fixtures, needs ffmpeg; time them on a
+#                                               device with scripts/bench/ExtractionBenchmark.tsx
+
+set -e
+
+ROOT_DIR="$(cd "$(dirname "$0")/.." && pwd)"
+CXX="${CXX:-c++}"
+
+case "$1" in
+    kernel)
+        BUILD_DIR="$(mktemp -d)"
+        trap 'rm -rf "$BUILD_DIR"' EXIT
+        # Same optimization level as the Android library
+        "$CXX" -std=c++17 -O3 -I"$ROOT_DIR/cpp" \
+            "$ROOT_DIR/scripts/bench/ReducerBenchmark.cpp" \
+            "$ROOT_DIR/cpp/WaveformReducer.cpp" \
+            "$ROOT_DIR/cpp/PeakPyramid.cpp" \
+            "$ROOT_DIR/cpp/PeakCache.cpp" \
+            -o "$BUILD_DIR/reducer-benchmark"
+        "$BUILD_DIR/reducer-benchmark"
+        ;;
+    fixtures)
+        OUT_DIR="${2:-$ROOT_DIR/bench-fixtures}"
+        command -v ffmpeg >/dev/null || { echo "ffmpeg is required"; exit 1; }
+        mkdir -p "$OUT_DIR"
+        # A fixed-seed noise bed under a swept tone, so every run writes the same audio
+        for MINUTES in 1 10 60; do
+            SOURCE="anoisesrc=seed=42:amplitude=0.1:duration=$((MINUTES * 60)),volume=0.5[n];sine=frequency=220:beep_factor=4:duration=$((MINUTES * 60))[s];[n][s]amix=inputs=2"
+            ffmpeg -y -loglevel error -filter_complex "$SOURCE" -ar 44100 -ac 2 -c:a aac -b:a 128k "$OUT_DIR/fixture-${MINUTES}min.m4a"
+            ffmpeg -y -loglevel error -filter_complex "$SOURCE" -ar 44100 -ac 2 -c:a libmp3lame -b:a 128k "$OUT_DIR/fixture-${MINUTES}min.mp3"
+            ffmpeg -y -loglevel error -filter_complex "$SOURCE" -ar 44100 -ac 2 -c:a pcm_s16le "$OUT_DIR/fixture-${MINUTES}min.wav"
+        done
+        echo "Fixtures written to $OUT_DIR"
+        ;;
+    *)
+        echo "Usage: ./scripts/bench.sh [kernel|fixtures [dir]]"
+        exit 1
+        ;;
+esac
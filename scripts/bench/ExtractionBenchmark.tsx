@@ -0,0 +1,119 @@
+/**
+ * Device timings of extractWaveformData on the fixtures written by
+ * `./scripts/bench.sh fixtures`. Copy the fixtures to the device, render
+ * <ExtractionBenchmark fixtures={[...paths]} /> as the only screen of a
+ * release build, and read the table from the screen or the log.
+ *
+ * Every fixture is extracted `runs` times with `useCache: false`. The first
+ * run after a fresh install is reported as cold, the median of the others as
+ * warm, next to the native decode and reduction time from getPerfStats.
+ */
+
+import React, { useEffect, useState } from 'react';
+import { Platform, ScrollView, Text } from 'react-native';
+import { useAudioPlayer } from '@bhojaniasgar/react-native-audio-waveform';
+
+export interface IExtractionTiming {
+  path: string;
+  coldMs: number;
+  warmMs: number;
+  decodeMs: number;
+  reductionMs: number;
+}
+
+interface IExtractionBenchmark {
+  fixtures: Array<string>;
+  // Values per extraction, as a Waveform of a few hundred candles asks for
+  noOfSamples?: number;
+  runs?: number;
+  onDone?: (timings: Array<IExtractionTiming>) => void;
+}
+
+const BENCHMARK_PLAYER_KEY = 'extraction-benchmark';
+
+const median = (values: Array<number>) => {
+  const sorted = [...values].sort((a, b) => a - b);
+  return sorted[Math.floor(sorted.length / 2)] ?? 0;
+};
+
+const row = (name: string, columns: Array<string>) =>
+  name.padEnd(26) + columns.map(column => column.padStart(10)).join(' ');
+
+const formatTimings = (timings: Array<IExtractionTiming>) =>
+  [
+    row('fixture', ['cold ms', 'warm ms', 'decode ms', 'reduce ms']),
+    ...timings.map(({ path, coldMs, warmMs, decodeMs, reductionMs }) =>
+      row(
+        path.split('/').pop() ?? path,
+        [coldMs, warmMs, decodeMs, reductionMs].map(ms => ms.toFixed(0))
+      )
+    ),
+  ].join('\n');
+
+export const ExtractionBenchmark = ({
+  fixtures,
+  noOfSamples = 500,
+  runs = 5,
+  onDone,
+}: IExtractionBenchmark) => {
+  const { extractWaveformData, setPerfStatsEnabled, getPerfStats } =
+    useAudioPlayer();
+  const [report, setReport] = useState('Running...');
+
+  useEffect(() => {
+    let isCancelled = false;
+    const run = async () => {
+      await setPerfStatsEnabled({ enabled: true });
+      const timings: Array<IExtractionTiming> = [];
+      for (const path of fixtures) {
+        // Drops the counters of the previous fixture
+        await getPerfStats({ reset: true });
+        const durations: Array<number> = [];
+        for (let index = 0; index < runs && !isCancelled; index++) {
+          const start = performance.now();
+          await extractWaveformData({
+            path,
+            playerKey: BENCHMARK_PLAYER_KEY,
+            noOfSamples,
+            useCache: false,
+          });
+          durations.push(performance.now() - start);
+        }
+        if (isCancelled) return;
+        const stats = (await getPerfStats({ reset: true }))[
+          BENCHMARK_PLAYER_KEY
+        ];
+        const extractions = Math.max(1, stats?.extractions ?? 0);
+        timings.push({
+          path,
+          coldMs: durations[0] ?? 0,
+          warmMs: median(durations.slice(1)),
+          decodeMs: (stats?.decodeMs ?? 0) / extractions,
+          reductionMs: (stats?.reductionMs ?? 0) / extractions,
+        });
+        setReport(formatTimings(timings));
+      }
+      await setPerfStatsEnabled({ enabled: false });
+      console.log(`[ExtractionBenchmark]\n${formatTimings(timings)}`);
+      onDone?.(timings);
+    };
+    run().catch(error => {
+      if (!isCancelled) setReport(`Failed: ${error}`);
+    });
+    return () => {
+      isCancelled = true;
+    };
+    // Runs once per mount, a new set of fixtures needs a fresh screen
+    // eslint-disable-next-line react-hooks/exhaustive-deps
+  }, []);
+
+  return (
+    <ScrollView>
+      <Text
+        style={{ fontFamily: Platform.OS === 'ios' ? 'Menlo' : 'monospace' }}
+      >
+        {report}
+      </Text>
+    </ScrollView>
+  );
+};
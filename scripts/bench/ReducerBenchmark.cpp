@@ -0,0 +1,275 @@
+//
+//  ReducerBenchmark.cpp
+//  AudioWaveform
+//
+//  Host micro-benchmark of the shared reduction kernel (cpp/), in the spirit
+//  of Jetpack Microbenchmark and XCTest `measure`: each case is warmed up,
+//  then timed over several runs, and the median throughput is reported. Built
+//  and run by scripts/bench.sh; compare numbers from the same machine only.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <vector>
+
+#include "PeakPyramid.h"
+#include "WaveformReducer.h"
+
+using audiowaveform::ChannelMode;
+using audiowaveform::PeakPyramid;
+using audiowaveform::SampleFormat;
+using audiowaveform::WaveformReducer;
+
+namespace {
+
+constexpr int kSampleRate = 44100;
+// One minute of audio per run, fed in decoder sized buffers
+constexpr size_t kFrames = kSampleRate * 60;
+constexpr size_t kBufferFrames = 4096;
+constexpr int kWarmupRuns = 3;
+constexpr int kRuns = 15;
+// A typical noOfSamples of a chat bubble
+constexpr int64_t kBuckets = 100;
+
+/// A decaying 440 Hz tone with some noise, either channel slightly apart
+std::vector<uint8_t> makePcm(SampleFormat format, int channels, size_t frames) {
+  std::vector<uint8_t> pcm(frames * channels * audiowaveform::bytesPerSample(format));
+  uint32_t seed = 1;
+  for (size_t frame = 0; frame < frames; ++frame) {
+    for (int channel = 0; channel < channels; ++channel) {
+      seed = seed * 1664525u + 1013904223u;
+      const float noise = static_cast<float>(seed >> 8) / static_cast<float>(1 << 24) - 0.5f;
+      const float envelope = 0.2f + 0.8f * static_cast<float>(frame % kSampleRate) / kSampleRate;
+      const float value = envelope * (0.8f * std::sin(frame * 2.0f * 3.14159265f * 440.0f / kSampleRate + channel) +
+                                      0.2f * noise);
+      const size_t index = frame * channels + channel;
+      switch (format) {
+      case SampleFormat::UInt8:
+        pcm[index] = static_cast<uint8_t>(std::lround(value * 127.0f) + 128);
+        break;
+      case SampleFormat::Int16:
+        reinterpret_cast<int16_t *>(pcm.data())[index] = static_cast<int16_t>(std::lround(value * 32767.0f));
+        break;
+      case SampleFormat::Float32:
+        reinterpret_cast<float *>(pcm.data())[index] = value;
+        break;
+      }
+    }
+  }
+  return pcm;
+}
+
+/// Median throughput of `run` over `samples` samples per run, in millions per second
+double measure(size_t samples, const std::function<void()> &run) {
+  for (int i = 0; i < kWarmupRuns; ++i) run();
+  std::vector<double> rates;
+  for (int i = 0; i < kRuns; ++i) {
+    const auto start = std::chrono::steady_clock::now();
+    run();
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    rates.push_back(samples / elapsed.count() / 1e6);
+  }
+  std::sort(rates.begin(), rates.end());
+  return rates[rates.size() / 2];
+}
+
+const char *name(SampleFormat format) {
+  switch (format) {
+  case SampleFormat::UInt8:
+    return "uint8";
+  case SampleFormat::Int16:
+    return "int16";
+  case SampleFormat::Float32:
+    return "float32";
+  }
+  return "?";
+}
+
+const char *name(ChannelMode mode) {
+  switch (mode) {
+  case ChannelMode::Mixdown:
+    return "mixdown";
+  case ChannelMode::Max:
+    return "max";
+  case ChannelMode::PerChannel:
+    return "perChannel";
+  }
+  return "?";
+}
+
+// Keeps the optimizer from dropping the reductions
+volatile float sink = 0.0f;
+
+/// Checks that a planar pyramid mixes its channels by power like an interleaved
+/// reduction, for channels at constant levels; the numbers are meaningless otherwise
+bool checkPlanarMixdown() {
+  const std::vector<std::vector<float>> cases = {{0.5f}, {0.5f, 0.5f}, {0.5f, 0.5f, 0.5f}, {0.2f, 0.4f, 0.6f}};
+  bool passed = true;
+  for (const std::vector<float> &levels : cases) {
+    const int channels = static_cast<int>(levels.size());
+    PeakPyramid pyramid(channels, kSampleRate, true);
+    double sumOfSquares = 0.0;
+    for (int channel = 0; channel < channels; ++channel) {
+      const std::vector<float> samples(kSampleRate, levels[channel]);
+      pyramid.processPlanar(channel, samples.data(), samples.size());
+      sumOfSquares += levels[channel] * levels[channel];
+    }
+    pyramid.finish();
+    const float expected = static_cast<float>(std::sqrt(sumOfSquares / channels));
+    for (const float rms : pyramid.levels().front().rms) {
+      if (std::fabs(rms - expected) > 1e-4f) {
+        std::printf("planar mixdown of %d channels: %.4f, expected %.4f\n", channels, rms, expected);
+        passed = false;
+        break;
+      }
+    }
+  }
+  return passed;
+}
+
+/// Checks that a short final bucket counts for the frames it holds when levels are halved:
+/// silence followed by a quarter bucket at full scale gives the same coarse
+/// value as a direct reduction of those frames
+bool checkShortFinalBucket() {
+  const int64_t framesPerBucket = PeakPyramid::baseFramesPerBucket(0);
+  const int64_t frames = 33 * framesPerBucket + framesPerBucket / 4;
+  std::vector<float> samples(static_cast<size_t>(frames), 0.0f);
+  std::fill(samples.begin() + 33 * framesPerBucket, samples.end(), 1.0f);
+  PeakPyramid pyramid(1, frames, true);
+  pyramid.processPlanar(0, samples.data(), samples.size());
+  pyramid.finish();
+  const float expected = static_cast<float>(std::sqrt(0.25 / 1.25));
+  const float rms = pyramid.levels().size() > 1 ? pyramid.levels()[1].rms.back() : 0.0f;
+  if (std::fabs(rms - expected) > 1e-4f) {
+    std::printf("short final bucket: %.4f, expected %.4f\n", rms, expected);
+    return false;
+  }
+  return true;
+}
+
+/// Reduces `pcm` in odd sized buffers, so buckets span buffers and kernels
+/// see tails, and flushes the partial bucket
+std::vector<float> reduceAll(WaveformReducer &reducer, const std::vector<uint8_t> &pcm, SampleFormat format) {
+  const size_t frameBytes = audiowaveform::bytesPerSample(format) * static_cast<size_t>(reducer.channels());
+  const size_t bufferBytes = 333 * frameBytes;
+  std::vector<float> rms(pcm.size() / frameBytes * reducer.valuesPerBucket() + reducer.valuesPerBucket());
+  std::vector<float> peak(rms.size());
+  size_t written = 0;
+  for (size_t offset = 0; offset < pcm.size(); offset += bufferBytes) {
+    const size_t size = std::min(bufferBytes, pcm.size() - offset);
+    const size_t values = reducer.valuesPerBucket();
+    written += reducer.process(pcm.data() + offset, size, format, rms.data() + written * values,
+                               peak.data() + written * values, reducer.maxBucketsFor(size, format));
+  }
+  written += reducer.flush(rms.data() + written * reducer.valuesPerBucket(),
+                           peak.data() + written * reducer.valuesPerBucket());
+  rms.resize(written * reducer.valuesPerBucket());
+  peak.resize(rms.size());
+  rms.insert(rms.end(), peak.begin(), peak.end());
+  return rms;
+}
+
+/// Checks that the vectorized per channel kernels give what a mono reduction
+/// of each channel does, for channel counts they cover and ones they do not
+bool checkPerChannel() {
+  constexpr size_t kCheckFrames = 10007;
+  constexpr int64_t kCheckFramesPerBucket = 1000;
+  bool passed = true;
+  for (const SampleFormat format : {SampleFormat::Int16, SampleFormat::Float32}) {
+    for (const int channels : {2, 3, 4}) {
+      const std::vector<uint8_t> pcm = makePcm(format, channels, kCheckFrames);
+      WaveformReducer reducer(channels, kCheckFramesPerBucket, ChannelMode::PerChannel);
+      const std::vector<float> values = reduceAll(reducer, pcm, format);
+      const size_t sampleSize = audiowaveform::bytesPerSample(format);
+      const size_t half = values.size() / 2;
+      for (int channel = 0; channel < channels; ++channel) {
+        std::vector<uint8_t> mono(kCheckFrames * sampleSize);
+        for (size_t frame = 0; frame < kCheckFrames; ++frame) {
+          std::copy_n(pcm.data() + (frame * channels + channel) * sampleSize, sampleSize,
+                      mono.data() + frame * sampleSize);
+        }
+        WaveformReducer monoReducer(1, kCheckFramesPerBucket);
+        const std::vector<float> expected = reduceAll(monoReducer, mono, format);
+        const size_t buckets = expected.size() / 2;
+        for (size_t bucket = 0; bucket < buckets && half == buckets * channels; ++bucket) {
+          const size_t index = bucket * channels + channel;
+          if (std::fabs(values[index] - expected[bucket]) > 1e-5f ||
+              values[half + index] != expected[buckets + bucket]) {
+            std::printf("per channel %s, channel %d of %d, bucket %zu: %.6f/%.6f, expected %.6f/%.6f\n",
+                        name(format), channel, channels, bucket, values[index], values[half + index],
+                        expected[bucket], expected[buckets + bucket]);
+            passed = false;
+            break;
+          }
+        }
+        if (half != buckets * channels) {
+          std::printf("per channel %s of %d channels: %zu values, expected %zu\n", name(format), channels, half,
+                      buckets * channels);
+          passed = false;
+        }
+      }
+    }
+  }
+  return passed;
+}
+
+} // namespace
+
+int main() {
+  if (!checkPlanarMixdown() || !checkShortFinalBucket() || !checkPerChannel()) return 1;
+  std::printf("%-22s %-8s %-8s %-11s %12s\n", "case", "format", "channels", "mode", "Msamples/s");
+  const SampleFormat formats[] = {SampleFormat::UInt8, SampleFormat::Int16, SampleFormat::Float32};
+  for (const SampleFormat format : formats) {
+    for (const int channels : {1, 2}) {
+      const std::vector<uint8_t> pcm = makePcm(format, channels, kFrames);
+      const size_t bufferBytes = kBufferFrames * channels * audiowaveform::bytesPerSample(format);
+      const size_t samples = kFrames * channels;
+
+      const ChannelMode modes[] = {ChannelMode::Mixdown, ChannelMode::Max, ChannelMode::PerChannel};
+      for (const ChannelMode mode : modes) {
+        if (channels == 1 && mode != ChannelMode::Mixdown) continue;
+        WaveformReducer reducer(channels, kFrames / kBuckets, mode);
+        std::vector<float> rms(kBuckets * channels);
+        std::vector<float> peak(kBuckets * channels);
+        const double rate = measure(samples, [&] {
+          reducer.reset();
+          size_t written = 0;
+          for (size_t offset = 0; offset < pcm.size(); offset += bufferBytes) {
+            const size_t size = std::min(bufferBytes, pcm.size() - offset);
+            written += reducer.process(pcm.data() + offset, size, format, rms.data() + written * reducer.valuesPerBucket(),
+                                       peak.data() + written * reducer.valuesPerBucket(), kBuckets - written);
+          }
+          sink = sink + rms[0];
+        });
+        std::printf("%-22s %-8s %-8d %-11s %12.1f\n", "reducer", name(format), channels, name(mode), rate);
+      }
+
+      const double pyramidRate = measure(samples, [&] {
+        PeakPyramid pyramid(channels, kFrames);
+        for (size_t offset = 0; offset < pcm.size(); offset += bufferBytes) {
+          pyramid.process(pcm.data() + offset, std::min(bufferBytes, pcm.size() - offset), format);
+        }
+        pyramid.finish();
+        sink = sink + pyramid.levels().front().rms[0];
+      });
+      std::printf("%-22s %-8s %-8d %-11s %12.1f\n", "pyramid", name(format), channels, "mixdown", pyramidRate);
+    }
+  }
+
+  // Normalization runs over results, not PCM, so it is reported per value
+  std::vector<float> values(1 << 16);
+  for (size_t i = 0; i < values.size(); ++i) values[i] = static_cast<float>(i % 997) / 997.0f;
+  std::vector<float> scratch(values.size());
+  const double normalizeRate = measure(values.size(), [&] {
+    scratch = values;
+    audiowaveform::normalize(scratch.data(), scratch.size(),
+                             audiowaveform::normalizationMax(scratch.data(), scratch.size(), 0.01f), 0.12f, 0.01f);
+    sink = sink + scratch[1];
+  });
+  std::printf("%-22s %-8s %-8s %-11s %12.1f\n", "normalize (Mvalues/s)", "float32", "-", "-", normalizeRate);
+  return 0;
+}
@@ -0,0 +1,70 @@
+import isNil from 'lodash/isNil';
+import { AudioWaveform } from './AudioWaveform';
+
+/** Installed by the native module into the JS runtime, see cpp/WaveformJsi.h. */
+interface IAudioWaveformJsi {
+  takeBuffer(id: number): ArrayBuffer | undefined;
+  recordingLevels(count: number): ArrayBuffer;
+  recordingLevelCount(): number;
+}
+
+const jsiGlobal = globalThis as { __AudioWaveformJsi?: IAudioWaveformJsi };
+
+// Several listeners can receive the same progress event, but the native
+// store hands each buffer out only once.
+const MAX_RECENT_BUFFERS = 16;
+const recentBuffers = new Map<number, Float32Array>();
+
+let installed: boolean | undefined;
+
+/**
+ * Installs the JSI bindings on first use. False when the JS runtime is not
+ * reachable, e.g. with remote debugging, in which case `binary` extraction
+ * must not be used.
+ */
+export const isJsiAvailable = (): boolean => {
+  if (isNil(installed)) {
+    try {
+      installed =
+        AudioWaveform.installJSIBindings() &&
+        !isNil(jsiGlobal.__AudioWaveformJsi);
+    } catch (error) {
+      installed = false;
+    }
+  }
+  return installed;
+};
+
+/**
+ * Returns the native buffer `id` as a Float32Array over the native memory,
+ * or null if it was dropped: the store drops progress slices JS fell behind
+ * on, and results only once many are left untaken, e.g. after a reload.
+ */
+export const takeWaveformBuffer = (id: number): Float32Array | null => {
+  const recent = recentBuffers.get(id);
+  if (!isNil(recent)) {
+    return recent;
+  }
+  const buffer = jsiGlobal.__AudioWaveformJsi?.takeBuffer(id);
+  if (isNil(buffer)) {
+    return null;
+  }
+  const values = new Float32Array(buffer);
+  recentBuffers.set(id, values);
+  if (recentBuffers.size > MAX_RECENT_BUFFERS) {
+    const oldest = recentBuffers.keys().next().value;
+    if (!isNil(oldest)) {
+      recentBuffers.delete(oldest);
+    }
+  }
+  return values;
+};
+
+/**
+ * The newest `count` levels of the current recording, oldest first, read
+ * from the native ring buffer. Empty when JSI is unavailable.
+ */
+export const readRecordingLevels = (count: number): Float32Array => {
+  const buffer = jsiGlobal.__AudioWaveformJsi?.recordingLevels(count);
+  return isNil(buffer) ? new Float32Array(0) : new Float32Array(buffer);
+};
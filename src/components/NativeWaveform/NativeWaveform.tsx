@@ -0,0 +1,10 @@
+import { requireNativeComponent } from 'react-native';
+import type { INativeWaveform } from './NativeWaveformTypes';
+
+/**
+ * Draws all candles of a waveform in one native view (Canvas on Android,
+ * CAShapeLayer on iOS). The samples are sent once; playback only updates
+ * `progress`.
+ */
+export const NativeWaveform =
+  requireNativeComponent<INativeWaveform>('AudioWaveformView');
@@ -0,0 +1,17 @@
+import type { ColorValue, ViewProps } from 'react-native';
+
+export interface INativeWaveform extends ViewProps {
+  samples: Array<number>;
+  // Played fraction of the samples, from 0 to 1; below 0 while the playhead has not reached them yet
+  progress: number;
+  // Wall clock time in milliseconds the progress was measured at
+  progressTimestamp?: number;
+  // Fraction of the waveform played per millisecond, to extrapolate the progress while playing
+  progressRate?: number;
+  playing?: boolean;
+  candleWidth: number;
+  candleSpace: number;
+  candleHeightScale: number;
+  waveColor?: ColorValue;
+  scrubColor?: ColorValue;
+}
@@ -0,0 +1,2 @@
+export * from './NativeWaveform';
+export * from './NativeWaveformTypes';
@@ -7,18 +7,25 @@ import React, {
   forwardRef,
   useEffect,
   useImperativeHandle,
+  useMemo,
   useRef,
   useState,
 } from 'react';
 import {
+  Animated,
   PanResponder,
+  Pressable,
   ScrollView,
   View,
+  type GestureResponderEvent,
   type LayoutRectangle,
+  type NativeScrollEvent,
+  type NativeSyntheticEvent,
   type NativeTouchEvent,
 } from 'react-native';
 import {
   DurationType,
+  ExtractionProgressMode,
   FinishMode,
   PermissionStatus,
   playbackSpeedThreshold,
@@ -31,7 +38,9 @@ import {
   useAudioPlayer,
   useAudioRecorder,
 } from '../../hooks';
+import { isJsiAvailable, readRecordingLevels } from '../../AudioWaveformJsi';
 import type { IStartRecording } from '../../types';
+import { NativeWaveform } from '../NativeWaveform';
 import { WaveformCandle } from '../WaveformCandle';
 import styles from './WaveformStyles';
 import {
@@ -64,6 +73,10 @@ export const Waveform = forwardRef<IWaveformRef, IWaveform>((props, ref) => {
     candleHeightScale = 3,
     onChangeWaveformLoadState = (_state: boolean) => {},
     showsHorizontalScrollIndicator = false,
+    extractionPriority = 0,
+    nativeRenderer = true,
+    zoom = 1,
+    overscan = 20,
   } = props as StaticWaveform & LiveWaveform;
   const viewRef = useRef<View>(null);
   const scrollRef = useRef<ScrollView>(null);
@@ -71,6 +84,8 @@ export const Waveform = forwardRef<IWaveformRef, IWaveform>((props, ref) => {
   const isAutoPaused = useRef<boolean>(false);
   const isAudioPlaying = useRef<boolean>(false);
   const [waveform, setWaveform] = useState<number[]>([]);
+  // Width of the played copy of the candles, moved without re-rendering them
+  const scrubWidth = useRef(new Animated.Value(0)).current;
   const [viewLayout, setViewLayout] = useState<LayoutRectangle | null>(null);
   const [seekPosition, setSeekPosition] = useState<NativeTouchEvent | null>(
     null
@@ -78,17 +93,36 @@ export const Waveform = forwardRef<IWaveformRef, IWaveform>((props, ref) => {
   const [songDuration, setSongDuration] = useState<number>(0);
   const [noOfSamples, setNoOfSamples] = useState<number>(0);
   const [currentProgress, setCurrentProgress] = useState<number>(0);
+  // When and at which speed currentProgress was read, to extrapolate it
+  const [playbackClock, setPlaybackClock] = useState({
+    timestamp: 0,
+    speed: 1,
+    isPlaying: false,
+  });
   const [panMoving, setPanMoving] = useState(false);
   const [playerState, setPlayerState] = useState(PlayerState.stopped);
   const [recorderState, setRecorderState] = useState(RecorderState.stopped);
   const [isWaveformExtracted, setWaveformExtracted] = useState(false);
+  // A zoomed waveform is wider than the view and scrolls, only the candles
+  // between first and last are rendered
+  const isZoomed = mode === 'static' && zoom > 1;
+  const candleStep = candleWidth + candleSpace;
+  const scrollOffset = useRef<number>(0);
+  const isUserScrolling = useRef<boolean>(false);
+  const [candleWindow, setCandleWindow] = useState({ first: 0, last: 0 });
   const audioSpeed: number =
     playbackSpeed > playbackSpeedThreshold ? 1.0 : playbackSpeed;
+  // Progress listeners expect every tick, otherwise the playhead is
+  // extrapolated between rare position events
+  const interpolatePosition = isNil(
+    (props as StaticWaveform).onCurrentProgressChange
+  );
 
   const {
-    extractWaveformData,
+    prepareWithWaveform,
     preparePlayer,
     getDuration,
+    extractWaveformData,
     seekToPlayer,
     playPlayer,
     stopPlayer,
@@ -98,6 +132,7 @@ export const Waveform = forwardRef<IWaveformRef, IWaveform>((props, ref) => {
     onCurrentRecordingWaveformData,
     setPlaybackSpeed,
     markPlayerAsUnmounted,
+    cancelWaveformExtraction,
   } = useAudioPlayer();
 
   const { startRecording, stopRecording, pauseRecording, resumeRecording } =
@@ -134,6 +169,7 @@ export const Waveform = forwardRef<IWaveformRef, IWaveform>((props, ref) => {
           updateFrequency: UpdateFrequency.medium,
           volume: volume,
           progress,
+          interpolatePosition,
         });
         return Promise.resolve(prepare);
       } catch (err) {
@@ -166,36 +202,37 @@ export const Waveform = forwardRef<IWaveformRef, IWaveform>((props, ref) => {
     }
   };
 
-  const preparePlayerAndGetDuration = async () => {
-    try {
-      const prepare = await preparePlayerForPath();
-      if (prepare) {
-        const duration = await getAudioDuration();
-        if (duration < 0) {
-          await getAudioDuration();
-        }
-      }
-    } catch (err) {
-      onError(err as Error);
-    }
-  };
-
   const getAudioWaveFormForPath = async (noOfSample: number) => {
     if (!isNil(path) && !isEmpty(path)) {
       try {
         onChangeWaveformLoadState(true);
-        const result = await extractWaveformData({
-          path: path,
-          playerKey: `PlayerFor${path}`,
-          noOfSamples: Math.max(noOfSample, 1),
-        });
+        // The player prepares while the waveform decodes
+        const { waveformData, duration, playerError } =
+          await prepareWithWaveform({
+            path: path,
+            playerKey: `PlayerFor${path}`,
+            noOfSamples: Math.max(noOfSample, 1),
+            priority: extractionPriority,
+            updateFrequency: UpdateFrequency.medium,
+            volume: volume,
+            interpolatePosition,
+          });
         onChangeWaveformLoadState(false);
 
-        if (!isNil(result) && !isEmpty(result)) {
-          const waveforms = head(result);
+        if (!isNil(waveformData) && !isEmpty(waveformData)) {
+          const waveforms = head(waveformData);
           if (!isNil(waveforms) && !isEmpty(waveforms)) {
             setWaveform(waveforms);
-            await preparePlayerAndGetDuration();
+            // The waveform is shown regardless, and the player prepared
+            // again on play since it does not count as extracted
+            if (!isNil(playerError)) {
+              throw new Error(playerError);
+            }
+            if (duration > 0) {
+              setSongDuration(duration);
+            } else {
+              await getAudioDuration();
+            }
             setWaveformExtracted(true);
           }
         }
@@ -210,6 +247,30 @@ export const Waveform = forwardRef<IWaveformRef, IWaveform>((props, ref) => {
     }
   };
 
+  // Once the waveform is extracted, a new resolution for a zoom or layout
+  // change is resampled from the native peak cache without preparing the
+  // player again
+  const resampleWaveformForPath = async (noOfSample: number) => {
+    try {
+      onChangeWaveformLoadState(true);
+      const waveformData = await extractWaveformData({
+        path: path,
+        playerKey: `PlayerFor${path}`,
+        noOfSamples: Math.max(noOfSample, 1),
+        priority: extractionPriority,
+        progressMode: ExtractionProgressMode.none,
+      });
+      onChangeWaveformLoadState(false);
+      const waveforms = head(waveformData);
+      if (!isNil(waveforms) && !isEmpty(waveforms)) {
+        setWaveform(waveforms);
+      }
+    } catch (err) {
+      onChangeWaveformLoadState(false);
+      onError(err as Error);
+    }
+  };
+
   const stopPlayerAction = async (resetProgress = true) => {
     if (mode === 'static') {
       try {
@@ -426,7 +487,7 @@ export const Waveform = forwardRef<IWaveformRef, IWaveform>((props, ref) => {
   useEffect(() => {
     if (!isNil(viewLayout?.width)) {
       const getNumberOfSamples = floor(
-        (viewLayout?.width ?? 0) / (candleWidth + candleSpace)
+        ((viewLayout?.width ?? 0) * (isZoomed ? zoom : 1)) / candleStep
       );
 
       // when orientation changes, the layout needs to be recalculated
@@ -436,43 +497,62 @@ export const Waveform = forwardRef<IWaveformRef, IWaveform>((props, ref) => {
 
       setNoOfSamples(getNumberOfSamples);
       if (mode === 'static') {
-        getAudioWaveFormForPath(getNumberOfSamples);
+        if (isWaveformExtracted) {
+          resampleWaveformForPath(getNumberOfSamples);
+        } else {
+          getAudioWaveFormForPath(getNumberOfSamples);
+        }
       }
     }
     // eslint-disable-next-line react-hooks/exhaustive-deps
-  }, [viewLayout?.width, mode, candleWidth, candleSpace]);
+  }, [viewLayout?.width, mode, candleWidth, candleSpace, isZoomed, zoom]);
 
-  const seekToPlayerAction = async () => {
-    if (!isNil(seekPosition)) {
-      if (mode === 'static') {
-        const seekAmount =
-          (seekPosition?.pageX - (viewLayout?.x ?? 0)) /
-          (viewLayout?.width ?? 1);
-        const clampedSeekAmount = clamp(seekAmount, 0, 1);
-
-        if (!panMoving) {
-          try {
-            await seekToPlayer({
-              playerKey: `PlayerFor${path}`,
-              progress: clampedSeekAmount * songDuration,
-            });
-          } catch {
-            if (playerState === PlayerState.paused) {
-              // If the player is not prepared, triggering the stop will reset the player for next click. Fix blocked paused player after a call to `stopAllPlayers`
-              await stopPlayerAction(false);
-            }
-          }
-
-          if (playerState === PlayerState.playing) {
-            startPlayerAction();
+  const seekToAmount = async (seekAmount: number) => {
+    if (mode === 'static') {
+      const clampedSeekAmount = clamp(seekAmount, 0, 1);
+
+      if (!panMoving) {
+        try {
+          await seekToPlayer({
+            playerKey: `PlayerFor${path}`,
+            progress: clampedSeekAmount * songDuration,
+          });
+        } catch {
+          if (playerState === PlayerState.paused) {
+            // If the player is not prepared, triggering the stop will reset the player for next click. Fix blocked paused player after a call to `stopAllPlayers`
+            await stopPlayerAction(false);
           }
         }
 
-        setCurrentProgress(clampedSeekAmount * songDuration);
+        if (playerState === PlayerState.playing) {
+          startPlayerAction();
+        }
       }
+
+      setCurrentProgress(clampedSeekAmount * songDuration);
+    }
+  };
+
+  const seekToPlayerAction = async () => {
+    if (!isNil(seekPosition)) {
+      await seekToAmount(
+        (seekPosition?.pageX - (viewLayout?.x ?? 0)) / (viewLayout?.width ?? 1)
+      );
     }
   };
 
+  // A zoomed waveform scrolls on drags, so it seeks on taps instead, to the
+  // tapped candle of the whole waveform
+  const seekToPressAction = (event: GestureResponderEvent) => {
+    const { pageX } = event.nativeEvent;
+    viewRef.current?.measureInWindow(x => {
+      seekToAmount(
+        (pageX - x + scrollOffset.current) /
+          Math.max(waveform.length * candleStep, 1)
+      );
+    });
+  };
+
   useEffect(() => {
     seekToPlayerAction();
     // eslint-disable-next-line react-hooks/exhaustive-deps
@@ -498,23 +578,35 @@ export const Waveform = forwardRef<IWaveformRef, IWaveform>((props, ref) => {
         } else {
           setCurrentProgress(0);
         }
+        setPlaybackClock({
+          timestamp: data.timestamp ?? Date.now(),
+          speed: data.speed ?? 1,
+          isPlaying: data.isPlaying ?? false,
+        });
       }
     });
 
     const traceRecorderWaveformValue = onCurrentRecordingWaveformData(
       result => {
         if (mode === 'live') {
-          if (!isNil(result.currentDecibel)) {
+          if (isJsiAvailable()) {
+            // The history stays in the native ring buffer, only the visible
+            // tail is read
+            setWaveform(Array.from(readRecordingLevels(maxCandlesToRender)));
+            if (scrollRef.current) {
+              scrollRef.current.scrollToEnd({ animated: true });
+            }
+          } else if (!isNil(result.currentDecibel)) {
             setWaveform((previousWaveform: number[]) => {
-              // Add the new decibel to the waveform
+              // Add the new decibel, or the batch of the pcm engine, to the waveform
               const updatedWaveform: number[] = [
                 ...previousWaveform,
-                result.currentDecibel,
+                ...(result.levels ?? [result.currentDecibel]),
               ];
 
               // Limit the size of the waveform array to 'maxCandlesToRender'
               return updatedWaveform.length > maxCandlesToRender
-                ? updatedWaveform.slice(1)
+                ? updatedWaveform.slice(-maxCandlesToRender)
                 : updatedWaveform;
             });
             if (scrollRef.current) {
@@ -533,6 +625,18 @@ export const Waveform = forwardRef<IWaveformRef, IWaveform>((props, ref) => {
     // eslint-disable-next-line react-hooks/exhaustive-deps
   }, []);
 
+  useEffect(() => {
+    return () => {
+      // Free the native scheduler slot of a waveform that is no longer shown
+      if (mode === 'static' && !isNil(path) && !isEmpty(path)) {
+        cancelWaveformExtraction({ playerKey: `PlayerFor${path}` }).catch(
+          () => {}
+        );
+      }
+    };
+    // eslint-disable-next-line react-hooks/exhaustive-deps
+  }, [path]);
+
   useEffect(() => {
     if (!isNil(onPlayerStateChange)) {
       (onPlayerStateChange as Function)(playerState);
@@ -609,6 +713,173 @@ export const Waveform = forwardRef<IWaveformRef, IWaveform>((props, ref) => {
     }
   }, [currentProgress, songDuration, onCurrentProgressChange]);
 
+  // The candles rendered to cover the screen at `offset`, kept while the
+  // visible ones stay inside them so that scrolling re-renders once per
+  // overscan instead of on every scroll event
+  const windowFor = (
+    offset: number,
+    current: { first: number; last: number }
+  ) => {
+    const firstVisible = clamp(floor(offset / candleStep), 0, waveform.length);
+    const lastVisible = clamp(
+      Math.ceil((offset + (viewLayout?.width ?? 0)) / candleStep),
+      0,
+      waveform.length
+    );
+    if (firstVisible >= current.first && lastVisible <= current.last) {
+      return current;
+    }
+    return {
+      first: Math.max(firstVisible - overscan, 0),
+      last: Math.min(lastVisible + overscan, waveform.length),
+    };
+  };
+
+  useEffect(() => {
+    if (isZoomed) {
+      setCandleWindow(windowFor(scrollOffset.current, { first: 0, last: 0 }));
+    }
+    // eslint-disable-next-line react-hooks/exhaustive-deps
+  }, [isZoomed, waveform.length, viewLayout?.width, candleStep, overscan]);
+
+  const onScroll = (event: NativeSyntheticEvent<NativeScrollEvent>) => {
+    scrollOffset.current = event.nativeEvent.contentOffset.x;
+    setCandleWindow(current => windowFor(scrollOffset.current, current));
+  };
+
+  const windowFirst = isZoomed ? candleWindow.first : 0;
+  const windowLast = isZoomed ? candleWindow.last : waveform.length;
+  const windowLength = Math.max(windowLast - windowFirst, 0);
+  const windowSamples = useMemo(
+    () => (isZoomed ? waveform.slice(windowFirst, windowLast) : waveform),
+    [isZoomed, waveform, windowFirst, windowLast]
+  );
+
+  const isExtrapolating =
+    playerState === PlayerState.playing &&
+    playbackClock.isPlaying &&
+    songDuration > 0;
+
+  useEffect(() => {
+    let width = -1;
+    const showPosition = (position: number) => {
+      // Whole candles are played, the same split the native view draws
+      const played =
+        songDuration > 0
+          ? Math.ceil((position / songDuration) * noOfSamples)
+          : 0;
+      // The scrub clip starts at the first rendered candle
+      const next = clamp(played - windowFirst, 0, waveform.length) * candleStep;
+      if (next !== width) {
+        width = next;
+        scrubWidth.setValue(next);
+      }
+    };
+    showPosition(currentProgress);
+    // The native view follows the playhead on its own display link
+    if (!isExtrapolating || nativeRenderer) {
+      return;
+    }
+    let frame = 0;
+    const followPlayhead = () => {
+      const elapsed = Math.max(0, Date.now() - playbackClock.timestamp);
+      showPosition(
+        Math.min(currentProgress + elapsed * playbackClock.speed, songDuration)
+      );
+      frame = requestAnimationFrame(followPlayhead);
+    };
+    frame = requestAnimationFrame(followPlayhead);
+    return () => cancelAnimationFrame(frame);
+  }, [
+    currentProgress,
+    playbackClock,
+    isExtrapolating,
+    nativeRenderer,
+    songDuration,
+    noOfSamples,
+    waveform.length,
+    candleStep,
+    windowFirst,
+    scrubWidth,
+  ]);
+
+  // A zoomed waveform scrolls the playhead back on screen while playing,
+  // unless the user is scrolling it
+  useEffect(() => {
+    if (
+      !isZoomed ||
+      playerState !== PlayerState.playing ||
+      songDuration <= 0 ||
+      isUserScrolling.current
+    ) {
+      return;
+    }
+    const playheadX =
+      (currentProgress / songDuration) * waveform.length * candleStep;
+    const width = viewLayout?.width ?? 0;
+    if (
+      playheadX < scrollOffset.current ||
+      playheadX > scrollOffset.current + width
+    ) {
+      scrollRef.current?.scrollTo({ x: playheadX, animated: true });
+    }
+    // eslint-disable-next-line react-hooks/exhaustive-deps
+  }, [currentProgress, playerState, isZoomed]);
+
+  const renderCandles = (played: boolean) =>
+    waveform
+      ?.slice?.(windowFirst, windowLast)
+      ?.map?.((amplitude, indexInWindow) => (
+        <WaveformCandle
+          key={windowFirst + indexInWindow}
+          index={windowFirst + indexInWindow}
+          amplitude={amplitude}
+          parentViewLayout={viewLayout}
+          played={played}
+          {...{
+            candleWidth,
+            candleSpace,
+            waveColor,
+            scrubColor,
+            candleHeightScale,
+          }}
+        />
+      ));
+
+  // The candle elements only change with the waveform or its layout, so
+  // progress updates leave them alone and React skips them.
+  const waveCandles = useMemo(
+    () => renderCandles(false),
+    // eslint-disable-next-line react-hooks/exhaustive-deps
+    [
+      waveform,
+      windowFirst,
+      windowLast,
+      viewLayout,
+      candleWidth,
+      candleSpace,
+      waveColor,
+      scrubColor,
+      candleHeightScale,
+    ]
+  );
+  const scrubCandles = useMemo(
+    () => (mode === 'static' ? renderCandles(true) : null),
+    // eslint-disable-next-line react-hooks/exhaustive-deps
+    [
+      mode,
+      waveform,
+      windowFirst,
+      windowLast,
+      viewLayout,
+      candleWidth,
+      candleSpace,
+      waveColor,
+      scrubColor,
+      candleHeightScale,
+    ]
+  );
+
   /* Ensure that the audio player is released (or stopped) once the song's duration is determined, 
   especially if the audio is not playing immediately after loading */
   useEffect(() => {
@@ -636,38 +907,109 @@ export const Waveform = forwardRef<IWaveformRef, IWaveform>((props, ref) => {
     playerKey: path,
   }));
 
-  return (
-    <View style={[styles.waveformContainer, containerStyle]}>
-      <View
-        ref={viewRef}
-        style={styles.waveformInnerContainer}
-        onLayout={calculateLayout}
-        {...(mode === 'static' ? panResponder.panHandlers : {})}>
+  // Played fraction of the rendered candles. Before the window it is
+  // negative, so the native view extrapolates into it at the right time.
+  const windowProgress =
+    songDuration > 0 && windowLength > 0
+      ? ((currentProgress / songDuration) * waveform.length - windowFirst) /
+        windowLength
+      : 0;
+  const windowProgressRate =
+    songDuration > 0 && windowLength > 0
+      ? (playbackClock.speed / songDuration) * (waveform.length / windowLength)
+      : 0;
+
+  const nativeWaveform = (
+    <NativeWaveform
+      style={styles.nativeWaveform}
+      samples={windowSamples}
+      progress={windowProgress}
+      progressTimestamp={playbackClock.timestamp}
+      progressRate={windowProgressRate}
+      playing={isExtrapolating}
+      {...{
+        candleWidth,
+        candleSpace,
+        candleHeightScale,
+        waveColor,
+        scrubColor,
+      }}
+    />
+  );
+
+  const candleRow = (
+    <View style={styles.candleRow}>
+      {waveCandles}
+      {!isNil(scrubCandles) && (
+        <Animated.View style={[styles.scrubClip, { width: scrubWidth }]}>
+          <View style={styles.candleRow}>{scrubCandles}</View>
+        </Animated.View>
+      )}
+    </View>
+  );
+
+  const renderWaveform = () => {
+    if (isZoomed) {
+      return (
         <ScrollView
           horizontal
           showsHorizontalScrollIndicator={showsHorizontalScrollIndicator}
           ref={scrollRef}
           style={styles.scrollContainer}
-          scrollEnabled={mode === 'live'}>
-          {waveform?.map?.((amplitude, indexCandle) => (
-            <WaveformCandle
-              key={indexCandle}
-              index={indexCandle}
-              amplitude={amplitude}
-              parentViewLayout={viewLayout}
-              {...{
-                candleWidth,
-                candleSpace,
-                noOfSamples,
-                songDuration,
-                currentProgress,
-                waveColor,
-                scrubColor,
-                candleHeightScale,
-              }}
-            />
-          ))}
+          scrollEventThrottle={16}
+          onScroll={onScroll}
+          onScrollBeginDrag={() => {
+            isUserScrolling.current = true;
+          }}
+          onScrollEndDrag={() => {
+            isUserScrolling.current = false;
+          }}
+          onMomentumScrollBegin={() => {
+            isUserScrolling.current = true;
+          }}
+          onMomentumScrollEnd={() => {
+            isUserScrolling.current = false;
+          }}>
+          <Pressable
+            style={[styles.candleRow, { width: waveform.length * candleStep }]}
+            onPress={seekToPressAction}>
+            <View
+              style={[
+                styles.candleWindow,
+                {
+                  left: windowFirst * candleStep,
+                  width: windowLength * candleStep,
+                },
+              ]}>
+              {nativeRenderer ? nativeWaveform : candleRow}
+            </View>
+          </Pressable>
         </ScrollView>
+      );
+    }
+    if (mode === 'static' && nativeRenderer) {
+      return nativeWaveform;
+    }
+    return (
+      <ScrollView
+        horizontal
+        showsHorizontalScrollIndicator={showsHorizontalScrollIndicator}
+        ref={scrollRef}
+        style={styles.scrollContainer}
+        scrollEnabled={mode === 'live'}>
+        {candleRow}
+      </ScrollView>
+    );
+  };
+
+  return (
+    <View style={[styles.waveformContainer, containerStyle]}>
+      <View
+        ref={viewRef}
+        style={styles.waveformInnerContainer}
+        onLayout={calculateLayout}
+        {...(mode === 'static' && !isZoomed ? panResponder.panHandlers : {})}>
+        {renderWaveform()}
       </View>
     </View>
   );
@@ -9,6 +9,26 @@ const styles = StyleSheet.create({
   scrollContainer: {
     height: '100%',
   },
+  candleRow: {
+    flexDirection: 'row',
+    height: '100%',
+  },
+  candleWindow: {
+    bottom: 0,
+    position: 'absolute',
+    top: 0,
+  },
+  scrubClip: {
+    bottom: 0,
+    left: 0,
+    overflow: 'hidden',
+    position: 'absolute',
+    top: 0,
+  },
+  nativeWaveform: {
+    flex: 1,
+    height: '100%',
+  },
   waveformContainer: {
     backgroundColor: Colors.transparent,
     height: 60,
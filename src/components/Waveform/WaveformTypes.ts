@@ -29,6 +29,14 @@ export interface StaticWaveform extends BaseWaveform {
   ) => void;
   onChangeWaveformLoadState?: (state: boolean) => void;
   playbackSpeed?: PlaybackSpeedType;
+  // Priority of this waveform's extraction in the native scheduler, higher starts first
+  extractionPriority?: number;
+  // Draw the candles in a single native view instead of one React view per candle
+  nativeRenderer?: boolean;
+  // Width of the waveform in widths of the view. Above 1 it scrolls horizontally and only the candles on screen are rendered
+  zoom?: number;
+  // Candles rendered past either edge of the screen of a zoomed waveform
+  overscan?: number;
 }
 
 export interface LiveWaveform extends BaseWaveform {
@@ -5,9 +5,8 @@ export interface IWaveformCandle {
   amplitude: number;
   candleWidth: number;
   candleSpace: number;
-  songDuration?: number;
-  noOfSamples?: number;
-  currentProgress?: number;
+  // Drawn in the scrub color, for the played copy of the waveform
+  played?: boolean;
   parentViewLayout: LayoutRectangle | null;
   waveColor?: string;
   scrubColor?: string;
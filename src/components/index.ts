@@ -1,2 +1,3 @@
+export * from './NativeWaveform';
 export * from './Waveform';
 export * from './WaveformCandle';
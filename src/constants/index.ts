@@ -6,6 +6,7 @@ export enum DurationType {
 export enum NativeEvents {
   onDidFinishPlayingAudio = 'onDidFinishPlayingAudio',
   onCurrentDuration = 'onCurrentDuration',
+  onCurrentDurations = 'onCurrentDurations',
   onCurrentExtractedWaveformData = 'onCurrentExtractedWaveformData',
   onCurrentRecordingWaveformData = 'onCurrentRecordingWaveformData',
 }
@@ -42,4 +43,29 @@ export enum UpdateFrequency {
   low = 1000.0,
 }
 
+export enum ExtractionProgressMode {
+  // All values extracted so far, throttled to `progressInterval`
+  full = 'full',
+  // Only the values added since the previous event, throttled to `progressInterval`
+  delta = 'delta',
+  // No progress events, only the resolved result
+  none = 'none',
+}
+
+export enum ChannelMode {
+  // One value per bucket over the samples of all channels
+  mixdown = 'mixdown',
+  // One value per bucket, of the loudest channel
+  max = 'max',
+  // Every channel's values one after the other, `noOfSamples` each
+  perChannel = 'perChannel',
+}
+
+export enum RecordingEngine {
+  // MediaRecorder on Android and AVAudioRecorder on iOS, levels polled from their metering
+  mediaRecorder = 'mediaRecorder',
+  // AudioRecord with a MediaCodec AAC encoder on Android, an AVAudioEngine input tap on iOS; a level per 10 ms
+  pcm = 'pcm',
+}
+
 export const playbackSpeedThreshold = 2.0;
@@ -1,22 +1,50 @@
+import isNil from 'lodash/isNil';
 import { NativeEventEmitter, NativeModules } from 'react-native';
 import { AudioWaveform } from '../AudioWaveform';
+import { isJsiAvailable, takeWaveformBuffer } from '../AudioWaveformJsi';
 import { NativeEvents } from '../constants';
 import {
+  type ICancelWaveformExtraction,
   type IDidFinishPlayings,
   type IExtractWaveform,
+  type IExtractedWaveformBatch,
   type IGetDuration,
+  type IGetPerfStats,
   type IOnCurrentDurationChange,
+  type IOnCurrentDurationsChange,
   type IOnCurrentExtractedWaveForm,
   type IOnCurrentRecordingWaveForm,
   type IPausePlayer,
+  type IPrefetchPlayer,
   type IPreparePlayer,
+  type IPrepareWithWaveform,
   type ISeekPlayer,
+  type ISetMaxConcurrentExtractions,
+  type ISetPerfStatsEnabled,
   type ISetPlaybackSpeed,
   type ISetVolume,
   type IStartPlayer,
   type IStopPlayer,
 } from '../types';
 
+// Values a delta extraction starts with room for before growing
+const MIN_EXTRACTED_CAPACITY = 1024;
+
+interface IExtractedValues {
+  buffer: Float32Array;
+  // The values so far, the rest of the buffer is spare capacity
+  length: number;
+}
+
+// Results are kept until taken, so a missing one was taken elsewhere
+const takeResultBuffer = (id: number): Float32Array => {
+  const values = takeWaveformBuffer(id);
+  if (isNil(values)) {
+    throw new Error(`Waveform buffer ${id} is no longer available`);
+  }
+  return values;
+};
+
 export const useAudioPlayer = () => {
   const audioPlayerEmitter = new NativeEventEmitter(
     NativeModules.AudioWaveformsEventEmitter
@@ -25,9 +53,58 @@ export const useAudioPlayer = () => {
   const extractWaveformData = (args: IExtractWaveform) =>
     AudioWaveform.extractWaveformData(args);
 
+  /**
+   * Same as `extractWaveformData`, with each result as a Float32Array. Uses
+   * `binary` transfer when the JSI bindings are available.
+   */
+  const extractWaveformBuffers = async (
+    args: IExtractWaveform
+  ): Promise<Array<Float32Array>> => {
+    if (!isJsiAvailable()) {
+      const result = await AudioWaveform.extractWaveformData({
+        ...args,
+        binary: false,
+      });
+      return result.map(values => Float32Array.from(values));
+    }
+    // In binary mode the native side resolves one buffer id per result
+    const bufferIds = (await AudioWaveform.extractWaveformData({
+      ...args,
+      binary: true,
+    })) as unknown as Array<number>;
+    return bufferIds.map(id => takeResultBuffer(id));
+  };
+
+  /**
+   * Extracts several waveforms in one native call, which resolves them as one
+   * payload, and splits it into a Float32Array per item. An item that failed
+   * or was cancelled gets an empty array.
+   */
+  const extractWaveformDataBatch = async (
+    items: Array<IExtractWaveform>
+  ): Promise<Array<Float32Array>> => {
+    const binary = isJsiAvailable();
+    const result: IExtractedWaveformBatch =
+      await AudioWaveform.extractWaveformDataBatch({ items, binary });
+    const values = !isNil(result.bufferId)
+      ? takeResultBuffer(result.bufferId)
+      : Float32Array.from(result.waveformData ?? []);
+    let offset = 0;
+    return result.lengths.map(length => {
+      offset += length;
+      return values.subarray(offset - length, offset);
+    });
+  };
+
   const preparePlayer = (args: IPreparePlayer) =>
     AudioWaveform.preparePlayer(args);
 
+  const prepareWithWaveform = (args: IPrepareWithWaveform) =>
+    AudioWaveform.prepareWithWaveform(args);
+
+  const prefetchPlayer = (args: IPrefetchPlayer) =>
+    AudioWaveform.prefetchPlayer(args);
+
   const playPlayer = (args: IStartPlayer) => AudioWaveform.startPlayer(args);
 
   const pausePlayer = (args: IPausePlayer) => AudioWaveform.pausePlayer(args);
@@ -43,6 +120,18 @@ export const useAudioPlayer = () => {
   const stopAllWaveFormExtractors = () =>
     AudioWaveform.stopAllWaveFormExtractors();
 
+  const cancelWaveformExtraction = (args: ICancelWaveformExtraction) =>
+    AudioWaveform.cancelWaveformExtraction(args);
+
+  const setMaxConcurrentExtractions = (args: ISetMaxConcurrentExtractions) =>
+    AudioWaveform.setMaxConcurrentExtractions(args);
+
+  const setPerfStatsEnabled = (args: ISetPerfStatsEnabled) =>
+    AudioWaveform.setPerfStatsEnabled(args);
+
+  const getPerfStats = (args?: IGetPerfStats) =>
+    AudioWaveform.getPerfStats(args ?? {});
+
   const stopPlayersAndExtractors = () =>
     Promise.all([stopAllPlayers(), stopAllWaveFormExtractors()]);
 
@@ -56,20 +145,110 @@ export const useAudioPlayer = () => {
       result => callback(result)
     );
 
+  // The natives batch the positions of all players into one event per tick
   const onCurrentDuration = (
     callback: (result: IOnCurrentDurationChange) => void
   ) =>
-    audioPlayerEmitter.addListener(NativeEvents.onCurrentDuration, result =>
-      callback(result)
+    audioPlayerEmitter.addListener(
+      NativeEvents.onCurrentDurations,
+      (result: IOnCurrentDurationsChange) =>
+        result.durations.forEach(duration => callback(duration))
     );
 
   const onCurrentExtractedWaveformData = (
     callback: (result: IOnCurrentExtractedWaveForm) => void
-  ) =>
-    audioPlayerEmitter.addListener(
+  ) => {
+    // Delta progress events only carry the new values. They are written in
+    // place into one growable buffer per player, and the callback gets a view
+    // of the values so far, so an event costs its own size, not the whole
+    // waveform's.
+    const extracted = new Map<string, IExtractedValues>();
+    // Preview waveforms fill in the part the full pass has not reached yet
+    const previews = new Map<string, ArrayLike<number>>();
+
+    const writeDelta = (
+      playerKey: string,
+      fromIndex: number,
+      values: ArrayLike<number>
+    ) => {
+      const preview = previews.get(playerKey);
+      const previewLength = preview?.length ?? 0;
+      let state = extracted.get(playerKey);
+      if (isNil(state)) {
+        // The full pass overwrites the preview as it goes
+        state = {
+          buffer: new Float32Array(
+            Math.max(previewLength, MIN_EXTRACTED_CAPACITY)
+          ),
+          length: previewLength,
+        };
+        if (!isNil(preview)) {
+          state.buffer.set(preview);
+        }
+        extracted.set(playerKey, state);
+      }
+      const end = fromIndex + values.length;
+      if (end > state.buffer.length) {
+        // Doubled, so growing stays amortized constant per value
+        const grown = new Float32Array(Math.max(end, state.buffer.length * 2));
+        grown.set(state.buffer.subarray(0, state.length));
+        state.buffer = grown;
+      }
+      state.buffer.set(values, fromIndex);
+      state.length = Math.max(end, previewLength);
+      return state.buffer.subarray(0, state.length);
+    };
+
+    return audioPlayerEmitter.addListener(
       NativeEvents.onCurrentExtractedWaveformData,
-      result => callback(result)
+      (result: IOnCurrentExtractedWaveForm) => {
+        const values = isNil(result.bufferId)
+          ? result.waveformData
+          : takeWaveformBuffer(result.bufferId);
+        if (isNil(values)) {
+          // A slice dropped while JS was busy, the next events and the
+          // result still arrive
+          return;
+        }
+        if (result.preview) {
+          previews.set(result.playerKey, values);
+          extracted.delete(result.playerKey);
+          callback({ ...result, waveformData: values });
+          return;
+        }
+        const progress = Number(result.progress);
+        const preview = previews.get(result.playerKey);
+        let waveformData: IOnCurrentExtractedWaveForm['waveformData'];
+        if (!isNil(result.fromIndex)) {
+          waveformData = writeDelta(result.playerKey, result.fromIndex, values);
+        } else if (!isNil(preview) && progress < 1) {
+          // iOS pads full progress events with zeros, so the extracted part
+          // is measured by the progress rather than the length. Full events
+          // copy the whole waveform anyway.
+          const refined = Math.min(
+            values.length,
+            Math.round(progress * preview.length)
+          );
+          const merged = Array.from(preview);
+          for (let index = 0; index < refined; index++) {
+            merged[index] = values[index] ?? 0;
+          }
+          waveformData = merged;
+        } else {
+          waveformData = values;
+        }
+        if (progress >= 1) {
+          extracted.delete(result.playerKey);
+          previews.delete(result.playerKey);
+        }
+        if (waveformData === result.waveformData) {
+          callback(result);
+          return;
+        }
+        callback({ ...result, waveformData });
+      }
     );
+  };
 
   const onCurrentRecordingWaveformData = (
     callback: (result: IOnCurrentRecordingWaveForm) => void
@@ -88,6 +267,8 @@ export const useAudioPlayer = () => {
 
   return {
     extractWaveformData,
+    extractWaveformBuffers,
+    extractWaveformDataBatch,
     pausePlayer,
     playPlayer,
     preparePlayer,
@@ -104,5 +285,11 @@ export const useAudioPlayer = () => {
     markPlayerAsUnmounted,
     stopAllWaveFormExtractors,
     stopPlayersAndExtractors,
+    cancelWaveformExtraction,
+    setMaxConcurrentExtractions,
+    setPerfStatsEnabled,
+    getPerfStats,
+    prefetchPlayer,
+    prepareWithWaveform,
   };
 };
@@ -1,4 +1,5 @@
 import { AudioWaveform } from '../AudioWaveform';
+import { isJsiAvailable, readRecordingLevels } from '../AudioWaveformJsi';
 import type { IStartRecording } from '../types';
 
 export const useAudioRecorder = () => {
@@ -13,8 +14,16 @@ export const useAudioRecorder = () => {
 
   const getDecibel = () => AudioWaveform.getDecibel();
 
+  /**
+   * The newest `count` levels of the current recording from the native
+   * history, or null when the JSI bindings are unavailable.
+   */
+  const getRecordingLevels = (count: number): Float32Array | null =>
+    isJsiAvailable() ? readRecordingLevels(count) : null;
+
   return {
     getDecibel,
+    getRecordingLevels,
     pauseRecording,
     resumeRecording,
     startRecording,
@@ -4,10 +4,13 @@ export {
   type PlaybackSpeedType,
 } from './components';
 export {
+  ChannelMode,
+  ExtractionProgressMode,
   FinishMode,
   PermissionStatus,
   PlayerState,
   RecorderState,
+  RecordingEngine,
   UpdateFrequency,
 } from './constants';
 export { useAudioPermission, useAudioPlayer } from './hooks';
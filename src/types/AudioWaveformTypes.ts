@@ -1,8 +1,11 @@
 import type { NativeModule } from 'react-native';
 import type {
+  ChannelMode,
   DurationType,
+  ExtractionProgressMode,
   FinishMode,
   PermissionStatus,
+  RecordingEngine,
   UpdateFrequency,
 } from '../constants';
 
@@ -20,16 +23,167 @@ export interface IStartRecording extends IPlayerPath {
   fileNameFormat: string;
   useLegacy: boolean;
   updateFrequency?: UpdateFrequency;
+  /**
+   * `pcm` records from the microphone's PCM and measures a level for every
+   * 10 ms of audio, sent in batches of `updateFrequency` as `levels`. Android
+   * uses AudioRecord and a MediaCodec AAC encoder into an .m4a file, where
+   * `encoder` and `useLegacy` do not apply. iOS uses an AVAudioEngine input
+   * tap, metered off the main thread, with the file written by AVAudioFile.
+   * Defaults to `mediaRecorder`.
+   */
+  engine?: RecordingEngine;
+  /**
+   * With the `pcm` engine the recorder builds the waveform of the new file as
+   * it records and stores it in the peak cache, so `extractWaveformData` of
+   * the recording is served without decoding it. When set, `stopRecording`
+   * also resolves this many normalized values as its third element.
+   */
+  waveformSamples?: number;
 }
 
 export interface IExtractWaveform extends IPlayerKey, IPlayerPath {
   noOfSamples?: number;
+  /**
+   * When true, the result also contains the per-bucket peak amplitudes as a
+   * second array, next to the normalized RMS values.
+   */
+  withPeaks?: boolean;
+  /**
+   * Serve and store the result through the on-disk peak cache, keyed by the
+   * file's path, size and modification time. Defaults to true.
+   */
+  useCache?: boolean;
+  /**
+   * Extractions run through a native scheduler with a bounded number of
+   * concurrent decoders. Pending requests with a higher priority start first,
+   * e.g. for waveforms that are on screen. Defaults to 0.
+   */
+  priority?: number;
+  /**
+   * How `onCurrentExtractedWaveformData` reports progress. `full` (default)
+   * sends every bucket with all values so far; `delta` sends only the new
+   * values with their `fromIndex`, which `useAudioPlayer` appends again.
+   */
+  progressMode?: ExtractionProgressMode;
+  /**
+   * Minimum time between two progress events in `delta` mode, in
+   * milliseconds. Defaults to 16.
+   */
+  progressInterval?: number;
+  /**
+   * When true, waveform data crosses from native as binary buffers through
+   * the JSI bindings instead of bridge arrays: the promise resolves to buffer
+   * ids and progress is always sent in `delta` mode with a `bufferId`. Prefer
+   * `extractWaveformBuffers` of `useAudioPlayer`, which takes the buffers as
+   * Float32Arrays and falls back to arrays when JSI is unavailable.
+   */
+  binary?: boolean;
+  /**
+   * For an http(s) `path`: a local file to keep the downloaded audio in, for
+   * playback and later extractions, which then read it instead of the URL.
+   * On Android the waveform is extracted while the file downloads, through
+   * range requests; iOS downloads the whole file first.
+   */
+  downloadPath?: string;
+  /**
+   * How the channels of a multichannel file are combined, `mixdown` by
+   * default. With `perChannel` the waveform (and peaks) hold the
+   * `noOfSamples` values of the first channel, then those of the next one, so
+   * the channel count is the length divided by `noOfSamples`; progress events
+   * still carry the mixdown. Only `mixdown` results use the peak cache.
+   */
+  channelMode?: ChannelMode;
+  /**
+   * For files longer than about 30 seconds: decode short windows spread
+   * across the file first and send the approximate waveform as a progress
+   * event with `preview` set, usually within a few hundred milliseconds. The
+   * full extraction then runs as usual, and `onCurrentExtractedWaveformData`
+   * of `useAudioPlayer` shows the preview wherever it has not reached yet.
+   * Android only previews local files.
+   */
+  preview?: boolean;
+  /**
+   * The resolved waveform is scaled so its largest value becomes `scale`,
+   * 0.12 by default. Values below `threshold`, 0.01 by default, are zeroed and
+   * left out of the largest value. Progress events and peaks stay raw.
+   */
+  scale?: number;
+  threshold?: number;
+}
+
+export interface ICancelWaveformExtraction extends IPlayerKey {}
+
+export interface ISetMaxConcurrentExtractions {
+  maxConcurrentExtractions: number;
+}
+
+export interface ISetPerfStatsEnabled {
+  enabled: boolean;
+}
+
+export interface IGetPerfStats {
+  // Clear the counters once they are read
+  reset?: boolean;
+}
+
+export interface IPerfStats {
+  extractions: number;
+  // Wall time of the extractions from opening the file, reduction included
+  decodeMs: number;
+  // Time spent in the reduction kernel and the peak pyramid
+  reductionMs: number;
+  // Compressed bytes read on Android; on iOS the share of the file decoded
+  bytesRead: number;
+  cacheHits: number;
+  cacheMisses: number;
+  // Time extractions waited in the scheduler before they started
+  queueWaitMs: number;
+  // Progress and preview events sent
+  eventsEmitted: number;
+  // From preparePlayer until playback was first heard, of the latest prepare; -1 before
+  prepareToFirstAudioMs: number;
 }
 
+export interface IPrefetchPlayer extends IPlayerPath {}
+
 export interface IPreparePlayer extends IPlayerKey, IPlayerPath {
   updateFrequency?: UpdateFrequency;
   volume?: number;
   progress?: number;
+  /**
+   * Set when the listener extrapolates the position from the `timestamp` and
+   * `speed` of each `onCurrentDuration` event, like the Waveform component.
+   * Position events then only come about once a second, and right away on
+   * start, pause, seek and speed changes.
+   */
+  interpolatePosition?: boolean;
+}
+
+// The arguments of extractWaveformData and preparePlayer for the same file
+export interface IPrepareWithWaveform extends IExtractWaveform, IPreparePlayer {}
+
+export interface IExtractWaveformBatch {
+  // Each runs through the scheduler without progress events or peaks
+  items: Array<IExtractWaveform>;
+  // Resolve the concatenated values as one buffer id, see `binary` above
+  binary?: boolean;
+}
+
+export interface IExtractedWaveformBatch {
+  // The normalized waveforms of all items, one after the other
+  waveformData?: Array<number>;
+  bufferId?: number;
+  // The number of values of each item, 0 for one that failed or was cancelled
+  lengths: Array<number>;
+}
+
+export interface IPreparedWaveform {
+  // What extractWaveformData resolves to
+  waveformData: Array<Array<number>>;
+  // Duration in milliseconds, negative while the player does not know it yet
+  duration: number;
+  // Why the player could not be prepared; the waveform is still extracted
+  playerError?: string;
 }
 
 export interface IStartPlayer extends IPlayerKey {
@@ -60,15 +214,50 @@ export interface IDidFinishPlayings extends IPlayerKey {
 
 export interface IOnCurrentDurationChange extends IPlayerKey {
   currentDuration: number;
+  // Wall clock time in milliseconds the position was read at
+  timestamp?: number;
+  // Playback speed, the position advances by speed milliseconds per millisecond
+  speed?: number;
+  isPlaying?: boolean;
+}
+
+// One tick of the shared playback ticker, with every playing player
+export interface IOnCurrentDurationsChange {
+  durations: Array<IOnCurrentDurationChange>;
 }
 
 export interface IOnCurrentExtractedWaveForm extends IPlayerKey {
-  waveformData: Array<number>;
+  /**
+   * `useAudioPlayer().onCurrentExtractedWaveformData` passes the values so
+   * far of a `delta` extraction as a Float32Array view over a buffer it
+   * reuses: copy it to keep it past the next event.
+   */
+  waveformData: Array<number> | Float32Array;
   progress: number;
+  /**
+   * Set on the approximate waveform of a `preview` extraction, which comes
+   * before the progress events of the full pass.
+   */
+  preview?: boolean;
+  /**
+   * Set in `delta` progress mode: the index of the first value of
+   * `waveformData` in the whole waveform.
+   */
+  fromIndex?: number;
+  /**
+   * Set for `binary` extractions instead of `waveformData`: the native buffer
+   * holding the new values. `useAudioPlayer` takes it into `waveformData`.
+   */
+  bufferId?: number;
 }
 
 export interface IOnCurrentRecordingWaveForm {
   currentDecibel: number;
+  /**
+   * With the `pcm` engine: every level since the previous event, oldest
+   * first. `currentDecibel` is the last of them.
+   */
+  levels?: Array<number>;
 }
 
 export interface ISetPlaybackSpeed extends IPlayerKey {
@@ -116,9 +305,12 @@ export interface IAudioWaveforms extends NativeModule {
 
   /**
    * Stops the current recording.
-   * @returns A promise that resolves to an array of strings representing the recorded audio files.
+   * @returns A promise that resolves to the path and the duration in milliseconds of the recorded
+   * file, and with `waveformSamples` its waveform.
    */
-  stopRecording(): Promise<Array<string>>;
+  stopRecording(): Promise<
+    [path: string, duration: string, waveformData?: Array<number>]
+  >;
 
   /**
    * Pauses the current recording.
@@ -136,9 +328,30 @@ export interface IAudioWaveforms extends NativeModule {
    * Extracts waveform data from the recorded audio.
    * @param args - Arguments for extracting waveform data.
    * @returns A promise that resolves to an array of arrays representing the waveform data.
+   * The first array holds the normalized RMS values; with `withPeaks` the second holds the peaks.
    */
   extractWaveformData(args: IExtractWaveform): Promise<Array<Array<number>>>;
 
+  /**
+   * Extracts the waveforms of several files in one call, e.g. all rows of a
+   * list, and resolves them together in one payload.
+   * @param args - The extractions, and whether to resolve a binary buffer.
+   * @returns A promise that resolves to the concatenated waveforms and the length of each.
+   */
+  extractWaveformDataBatch(
+    args: IExtractWaveformBatch
+  ): Promise<IExtractedWaveformBatch>;
+
+  /**
+   * Prepares the player and extracts the waveform of the same file in one
+   * call, with the player preparing while the waveform decodes.
+   * @param args - The arguments of `extractWaveformData` and `preparePlayer`.
+   * @returns A promise that resolves to the waveform data and the duration once both are done.
+   * It only rejects when the extraction fails; a player that could not be
+   * prepared is reported in `playerError`, with a duration of -1.
+   */
+  prepareWithWaveform(args: IPrepareWithWaveform): Promise<IPreparedWaveform>;
+
   /**
    * Gets the decibel level of the recorded audio.
    * @returns A promise that resolves to the decibel level.
@@ -208,6 +421,54 @@ export interface IAudioWaveforms extends NativeModule {
    */
   stopAllWaveFormExtractors(): Promise<boolean>;
 
+  /**
+   * Cancels the pending or running waveform extraction of a player. Its
+   * `extractWaveformData` promise resolves with an empty waveform.
+   * @param args - The player key of the extraction to cancel.
+   * @returns A promise that resolves to a boolean indicating if there was an extraction to cancel.
+   */
+  cancelWaveformExtraction(args: ICancelWaveformExtraction): Promise<boolean>;
+
+  /**
+   * Prepares a player for a path ahead of playback and keeps it in a small
+   * native pool, so a later `preparePlayer` and start of that path skip the
+   * cold prepare. Stopped players are parked there as well.
+   * @param args - The path of the audio file to prepare.
+   * @returns A promise that resolves to false if a prepared player for the path was already pooled.
+   */
+  prefetchPlayer(args: IPrefetchPlayer): Promise<boolean>;
+
+  /**
+   * Sets how many waveform extractions may decode at the same time. The
+   * default is sized to the device's decoder instances and CPU cores.
+   * @param args - The maximum number of concurrent extractions, at least 1.
+   * @returns A promise that resolves to the limit in effect.
+   */
+  setMaxConcurrentExtractions(args: ISetMaxConcurrentExtractions): Promise<number>;
+
+  /**
+   * Turns the native performance counters read by `getPerfStats` on or off.
+   * They are off by default; turning them off keeps what was counted.
+   * @param args - Whether to count.
+   * @returns A promise that resolves to the new state.
+   */
+  setPerfStatsEnabled(args: ISetPerfStatsEnabled): Promise<boolean>;
+
+  /**
+   * Reads the performance counters, summed per player key since they were
+   * enabled or last reset.
+   * @param args - Whether to reset the counters after reading them.
+   * @returns A promise that resolves to the counters keyed by player key.
+   */
+  getPerfStats(args?: IGetPerfStats): Promise<Record<string, IPerfStats>>;
+
+  /**
+   * Installs the JSI bindings used by `binary` extractions. Synchronous, runs
+   * on the JS thread.
+   * @returns True if the bindings are installed.
+   */
+  installJSIBindings(): boolean;
+
   /**
    * Sets the playback speed of the audio.
    * @param args - The playback speed to set, where 1.0 is normal speed.